@@ -7,8 +7,11 @@
 #pragma once
 
 // ROS headers
-#include <message_filters/subscriber.h>
-#include <message_filters/time_synchronizer.h>
+#include <image_transport/image_transport.h>
+#include <image_transport/subscriber_filter.h>
+#include <message_filters/sync_policies/approximate_time.h>
+#include <message_filters/sync_policies/exact_time.h>
+#include <message_filters/synchronizer.h>
 #include <ros/ros.h>
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/image_encodings.h>
@@ -19,105 +22,377 @@
 // OpenCV header
 #include <opencv2/core/core.hpp>
 
+// OpenPose header
+#include <openpose/core/array.hpp>
+
+// ros_openpose headers
+#include <ros_openpose/tripleBuffer.hpp>
+
 // c++ headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <vector>
 
 namespace ros_openpose
 {
+  // the method used for reading the depth of a keypoint from the depth image
+  enum class DepthSampling
+  {
+    Nearest,   // the pixel the keypoint lies in
+    Bilinear,  // sub-pixel interpolation of the four neighboring pixels
+    Median,    // median of the valid pixels in a window around the keypoint
+    MinValid   // closest valid pixel in a window around the keypoint
+  };
+
+  // converts the name of a depth sampling method, i.e., nearest, bilinear, median or min,
+  // to its value. returns false if the name is unknown
+  bool stringToDepthSampling(const std::string& name, DepthSampling& depthSampling);
+
+  // the camera intrinsics used for deprojecting the pixels. they are cached when the
+  // camera info arrives, along with the reciprocals of the focal lengths
+  struct CameraIntrinsics
+  {
+    float fx, fy, cx, cy;
+    float fxInv, fyInv;
+  };
+
+  // a signal shared by several camera readers. it is raised whenever any of them receives a new
+  // frame, so that a single thread can wait for the frames of all the cameras at once
+  struct FrameSignal
+  {
+    std::mutex mutex;
+    std::condition_variable condition;
+    unsigned long long count = 0;
+  };
+
+  // keypoints in 3D space (wrt camera coordinate system) stored as structure of arrays.
+  // 'valid' tells whether the keypoint was detected and a valid depth was found for it
+  struct Keypoints3D
+  {
+    std::vector<float> x, y, z, score;
+    std::vector<unsigned char> valid;
+
+    size_t size() const
+    {
+      return z.size();
+    }
+
+    void resize(const size_t count)
+    {
+      x.resize(count);
+      y.resize(count);
+      z.resize(count);
+      score.resize(count);
+      valid.resize(count);
+    }
+  };
+
+  // the options of the synchronizer pairing the color and depth images
+  struct SyncOptions
+  {
+    // pair the images with the nearest timestamps instead of identical timestamps
+    bool approximate = false;
+
+    // the largest difference between the timestamps of a pair. zero means no limit.
+    // only used by the approximate policy
+    double maxInterval = 0.0;
+
+    // the queue size of the color and depth subscribers
+    int imageQueueSize = 1;
+
+    // the queue size of the synchronizer
+    int syncQueueSize = 4;
+
+    // the image_transport used for receiving the color and depth images, e.g., raw, compressed or
+    // compressedDepth. the compressed transports save bandwidth if the camera runs on another machine
+    std::string colorTransport = "raw", depthTransport = "raw";
+  };
+
+  // the counters of the synchronizer. the difference between the received messages and the
+  // pairs tells how many messages could not be matched, e.g., because the counterpart did not arrive
+  struct SyncStatistics
+  {
+    // messages received by the subscribers
+    unsigned long long colorReceived = 0, depthReceived = 0;
+
+    // messages lost before reaching the subscribers, e.g., because the subscriber queue was full.
+    // they are detected from the gaps in header.seq, hence only if the camera driver sets it
+    unsigned long long colorDropped = 0, depthDropped = 0;
+
+    // synchronized pairs of color and depth images
+    unsigned long long pairs = 0;
+
+    unsigned long long colorUnmatched() const
+    {
+      return colorReceived - pairs;
+    }
+
+    unsigned long long depthUnmatched() const
+    {
+      return depthReceived - pairs;
+    }
+  };
+
   class CameraReader
   {
   private:
-    cv::Mat mColorImage, mDepthImage;
-    cv::Mat mColorImageUsed, mDepthImageUsed;
+    // the latest synchronized frame. the images share their memory with the ros messages whenever possible.
+    // holding the cv_bridge pointers keeps the messages alive for as long as the images are in use
+    struct FrameSlot
+    {
+      cv_bridge::CvImageConstPtr colorImage, depthImage;
+
+      // the time at which the frame was received by the image callback and the time at which the
+      // callback handed it over, i.e., after converting the images
+      ros::Time callbackTime, readyTime;
+      unsigned long long number = 0;
+    };
+
+    // the frames are handed over from the image callback to the consumer without locking. the synchronizer
+    // invokes the image callback serially, hence it is the only producer
+    TripleBuffer<FrameSlot> mFrames;
+
+    // the number of the latest frame. it is incremented for every synchronized frame
+    std::atomic<unsigned long long> mFrameNumber{0};
+    unsigned long long mProducedFrames = 0;
+
+    // the number of the latest frame taken by the consumer, see waitForFrameTaken()
+    std::atomic<unsigned long long> mTakenFrameNumber{0};
+
     std::string mColorTopic, mDepthTopic, mCamInfoTopic;
     ros::NodeHandle mNh;
     ros::Subscriber mCamInfoSubscriber;
+
+    // signalled by the image callback whenever a new synchronized frame arrives. the mutex only serves
+    // the conditions, i.e., it never guards the frames
     std::mutex mMutex;
+    std::condition_variable mFrameCondition;
+
+    // signalled by the consumer whenever it takes a frame, but only while somebody waits for it, see
+    // waitForFrameTaken(). a live camera thus pays a single atomic load per frame
+    std::condition_variable mTakenCondition;
+    std::atomic<unsigned int> mTakenWaiters{0};
+
+    // optional signal raised along with the frame condition, see setFrameSignal(). it is accessed
+    // atomically (std::atomic_load and std::atomic_store)
+    std::shared_ptr<FrameSignal> mSPtrFrameSignal;
+
+    // whether the color and depth images are being received, see setActive()
+    std::atomic<bool> mActive;
+    std::mutex mActiveMutex;
+
+    // whether cv_bridge converts the color images to bgr8, see setColorConversion()
+    std::atomic<bool> mConvertColor{true};
 
-    // camera calibration parameters
+    // the method and the window size used for reading the depth of a keypoint
+    DepthSampling mDepthSampling = DepthSampling::Nearest;
+    int mDepthWindowSize = 1;
+
+    // camera calibration parameters. the intrinsics are written once by the camera info
+    // callback, the flag makes them visible to the other threads. the first camera info claims
+    // them, the later ones are ignored, as the lifting reads them without locking
     std::shared_ptr<sensor_msgs::CameraInfo> mSPtrCameraInfo;
-    std::shared_ptr<message_filters::Subscriber<sensor_msgs::Image>> mSPtrColorImageSub;
-    std::shared_ptr<message_filters::Subscriber<sensor_msgs::Image>> mSPtrDepthImageSub;
-    std::shared_ptr<message_filters::TimeSynchronizer<sensor_msgs::Image, sensor_msgs::Image>> mSPtrSyncSubscriber;
+    CameraIntrinsics mIntrinsics;
+
+    // the size of the image the intrinsics belong to, i.e., the color image. a smaller depth image, e.g., a
+    // decimated one, is scaled to it
+    int mImageWidth = 0, mImageHeight = 0;
+    std::atomic<bool> mHasIntrinsics{false};
+    std::atomic<bool> mCameraInfoClaimed{false};
+
+    // lookup table of the undistorted ray of each pixel, i.e., its normalized image coordinates
+    // (x / z, y / z). it is built once along with the intrinsics and stays empty if the camera
+    // has no lens distortion
+    std::vector<float> mRayTableX, mRayTableY;
+    int mRayTableWidth = 0, mRayTableHeight = 0;
+
+    // the images are received through image_transport, hence they may arrive compressed
+    std::shared_ptr<image_transport::ImageTransport> mSPtrImageTransport;
+    std::shared_ptr<image_transport::SubscriberFilter> mSPtrColorImageSub;
+    std::shared_ptr<image_transport::SubscriberFilter> mSPtrDepthImageSub;
+
+    // only one of the synchronizers is used, depending on the options
+    typedef message_filters::sync_policies::ExactTime<sensor_msgs::Image, sensor_msgs::Image> ExactSyncPolicy;
+    typedef message_filters::sync_policies::ApproximateTime<sensor_msgs::Image, sensor_msgs::Image> ApproximateSyncPolicy;
+    std::shared_ptr<message_filters::Synchronizer<ExactSyncPolicy>> mSPtrExactSyncSubscriber;
+    std::shared_ptr<message_filters::Synchronizer<ApproximateSyncPolicy>> mSPtrApproximateSyncSubscriber;
+    SyncOptions mSyncOptions;
+
+    // the counters of the synchronizer are updated by the subscriber callbacks
+    SyncStatistics mSyncStatistics, mReportedSyncStatistics;
+    uint32_t mLastColorSeq = 0, mLastDepthSeq = 0;
+    bool mHasColorSeq = false, mHasDepthSeq = false;
+    ros::WallTime mLastSyncReportTime;
+    mutable std::mutex mSyncStatisticsMutex;
 
     inline void subscribe();
+    void subscribeImages();
+    void colorCountCallback(const sensor_msgs::ImageConstPtr& colorMsg);
+    void depthCountCallback(const sensor_msgs::ImageConstPtr& depthMsg);
+    void countPair();
     void imageCallback(const sensor_msgs::ImageConstPtr& colorMsg, const sensor_msgs::ImageConstPtr& depthMsg);
+    static cv_bridge::CvImageConstPtr shareDepthImage(const sensor_msgs::ImageConstPtr& depthMsg);
     void camInfoCallback(const sensor_msgs::CameraInfoConstPtr& camMsg);
 
+    // builds the lookup table of the undistorted rays from the distortion coefficients
+    void buildRayTable(const sensor_msgs::CameraInfo& camInfo);
+
+    // reads the undistorted ray of the given pixel from the lookup table.
+    // returns false if the pixel is outside of the table
+    bool lookupRay(const float pixel_x, const float pixel_y, float& ray_x, float& ray_y) const;
+
+    // the factors mapping the pixels of the color image to the pixels of the depth image. they are one
+    // unless the depth image is decimated
+    void depthScale(const cv::Mat& depthImage, float& scale_x, float& scale_y) const;
+
+    // reads the depth (in meters) at the given pixel of the depth image.
+    // returns false if there is no valid depth
+    bool sampleDepth(const cv::Mat& depthImage, const float pixel_x, const float pixel_y, float& depthSI) const;
+
   public:
     // we don't want to instantiate using deafult constructor
     CameraReader() = delete;
 
-    // copy constructor
-    CameraReader(const CameraReader& other);
+    // the reader can not be copied, as the callbacks of its subscribers are bound to it. it is shared using
+    // std::shared_ptr instead
+    CameraReader(const CameraReader& other) = delete;
+    CameraReader& operator=(const CameraReader& other) = delete;
 
-    // copy assignment operator
-    CameraReader& operator=(const CameraReader& other);
-
-    // main constructor
+    // main constructor. an inactive reader does not subscribe to the images until setActive() is called, e.g.,
+    // until openpose is warmed up. the camera info is subscribed to right away
     CameraReader(ros::NodeHandle& nh, const std::string& colorTopic, const std::string& depthTopic,
-                 const std::string& camInfoTopic);
+                 const std::string& camInfoTopic, const SyncOptions& syncOptions = SyncOptions(),
+                 const bool active = true);
 
     // we are okay with default destructor
     ~CameraReader() = default;
 
-    // returns the latest color image from camera
-    // it locks the color frame. remember that we
-    // are just passing the pointer instead of copying whole data
-    const cv::Mat& getColorFrame()
+    // waits until a frame newer than 'frameNumber' is available or the timeout expires. on success,
+    // the color image and the depth image synchronized with it are shared (not copied) into 'colorImage'
+    // and 'depthImage', 'frameNumber' is updated and true is returned. a frame is therefore handed out
+    // only once. the returned pointers keep the underlying ros messages alive. the header of the color
+    // image carries the camera timestamp. 'callbackTime' is the time at which the frame was received by
+    // the image callback. the frames are taken without locking, hence only a single thread may call it
+    bool waitForNewFrame(cv_bridge::CvImageConstPtr& colorImage, cv_bridge::CvImageConstPtr& depthImage,
+                         unsigned long long& frameNumber, ros::Time& callbackTime,
+                         const std::chrono::milliseconds& timeout)
     {
-      mMutex.lock();
-      mColorImageUsed = mColorImage;
-      mMutex.unlock();
-      return mColorImageUsed;
+      ros::Time readyTime;
+      return waitForNewFrame(colorImage, depthImage, frameNumber, callbackTime, readyTime, timeout);
+    }
+
+    // same as above. 'readyTime' is the time at which the image callback handed the frame over, i.e., the
+    // images were converted in between
+    bool waitForNewFrame(cv_bridge::CvImageConstPtr& colorImage, cv_bridge::CvImageConstPtr& depthImage,
+                         unsigned long long& frameNumber, ros::Time& callbackTime, ros::Time& readyTime,
+                         const std::chrono::milliseconds& timeout)
+    {
+      // the mutex is only taken if we have to wait
+      if (mFrameNumber.load(std::memory_order_acquire) == frameNumber)
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mFrameCondition.wait_for(
+                lock, timeout, [&] { return mFrameNumber.load(std::memory_order_acquire) != frameNumber; }))
+          return false;
+      }
+
+      mFrames.update();
+      const auto& frame = mFrames.front();
+      if (frame.number == frameNumber)
+        return false;
+
+      colorImage = frame.colorImage;
+      depthImage = frame.depthImage;
+      frameNumber = frame.number;
+      callbackTime = frame.callbackTime;
+      readyTime = frame.readyTime;
+      // the store and the load are sequentially consistent, so that either the waiter sees the frame taken or
+      // we see the waiter. passing through the mutex makes sure that the waiter is already waiting
+      mTakenFrameNumber.store(frame.number);
+      if (mTakenWaiters.load() > 0)
+      {
+        {
+          std::lock_guard<std::mutex> lock(mMutex);
+        }
+        mTakenCondition.notify_all();
+      }
+      return true;
     }
 
-    // get the depth image from camera
-    // unsafe to call this function
-    // todo: remove this function
-    const cv::Mat& getDepthFrame()
+    // hands a synchronized frame over to the consumer as if it was received by the subscribers, e.g., a frame
+    // read from a bag. construct the reader with empty topics for not subscribing to any. it must not be called
+    // concurrently with the subscriber callbacks
+    void addFrame(const sensor_msgs::ImageConstPtr& colorMsg, const sensor_msgs::ImageConstPtr& depthMsg);
+
+    // sets the camera calibration parameters as if they were received by the subscriber. only the first
+    // camera info is used, whether it was set or received
+    void setCameraInfo(const sensor_msgs::CameraInfoConstPtr& camInfoMsg);
+
+    // waits until the consumer took the latest frame or the timeout expires. it lets the producer of the frames,
+    // see addFrame(), keep pace with the consumer instead of replacing the frames it did not take yet
+    bool waitForFrameTaken(const std::chrono::milliseconds& timeout);
+
+    // sets a signal which is raised, in addition to the own condition of the reader, whenever a new
+    // frame arrives. it lets a thread wait for any of several cameras. use a zero timeout with
+    // waitForNewFrame() afterwards for collecting the frames without blocking
+    void setFrameSignal(const std::shared_ptr<FrameSignal>& frameSignal)
     {
-      return mDepthImage;
+      std::atomic_store(&mSPtrFrameSignal, frameSignal);
     }
 
-    // copy the latest depth image from camera. remember that we
-    // are just passing the pointer instead of copying whole data
-    void copyLatestDepthImage()
+    // returns the counters of the synchronizer
+    SyncStatistics getSyncStatistics() const
     {
-      mMutex.lock();
-      mDepthImageUsed = mDepthImage;
-      mMutex.unlock();
+      std::lock_guard<std::mutex> lock(mSyncStatisticsMutex);
+      return mSyncStatistics;
     }
 
-    // compute the point in 3D space for a given pixel without considering distortion
-    void compute3DPoint(const float pixel_x, const float pixel_y, float (&point)[3])
+    // stops or resumes receiving the color and depth images, e.g., while nobody listens to the results.
+    // the subscribers are shut down meanwhile, so that the camera driver need not send the images
+    void setActive(const bool active);
+
+    // returns true unless receiving the images was stopped by setActive()
+    bool isActive() const
+    {
+      return mActive;
+    }
+
+    // enables or disables the conversion of the color images to bgr8. if disabled, the color images in
+    // bgr8, rgb8, bgra8, rgba8 or mono8 encoding are shared as they are, and the conversion is left to
+    // the consumer, e.g., the gpu. the images in other encodings are still converted by cv_bridge
+    void setColorConversion(const bool enabled)
+    {
+      mConvertColor = enabled;
+    }
+
+    // sets the method and the window size (in pixels of the depth image, odd) used for reading the depth of a
+    // keypoint
+    void setDepthSampling(const DepthSampling depthSampling, const int windowSize);
+
+    // compute the point in 3D space for a given pixel using the given depth image, i.e., the one
+    // synchronized with the color image the pixel belongs to. the depth image may be smaller than the color
+    // image, e.g., decimated by 2 or 4 for saving bandwidth. the lens distortion is taken into account
+    // if the camera info provides distortion coefficients. returns false if there is no valid depth at
+    // the pixel. the point is set to zero in this case
+    bool compute3DPoint(const cv::Mat& depthImage, const float pixel_x, const float pixel_y,
+                        float (&point)[3]) const;
+
+    // compute the points in 3D space for a batch of keypoints at once. 'keypoints' holds 'count'
+    // keypoints in openpose layout, i.e., (x, y, score). the points are written to 'points'
+    // starting at 'offset', which must be large enough. the points of invalid keypoints are set to zero
+    void liftKeypoints(const cv::Mat& depthImage, const float* keypoints, const size_t count, Keypoints3D& points,
+                       const size_t offset = 0) const;
+
+    // compute the points in 3D space for the whole keypoint array of openpose, i.e., all
+    // the keypoints of all the persons. 'points' is resized to the number of keypoints
+    void liftKeypoints(const cv::Mat& depthImage, const op::Array<float>& keypoints, Keypoints3D& points) const
     {
-      /*
-       * K.at(0) = intrinsic.fx
-       * K.at(4) = intrinsic.fy
-       * K.at(2) = intrinsic.ppx
-       * K.at(5) = intrinsic.ppy
-       */
-
-      // our depth image type is 16UC1 which has unsigned short as an underlying type
-      auto depth = mDepthImageUsed.at<unsigned short>(static_cast<int>(pixel_y), static_cast<int>(pixel_x));
-
-      // no need to proceed further if the depth is zero
-      // the depth represents the distance of an object placed infront of the camera
-      // therefore depth must be always a positive number
-      if (depth <= 0)
-        return;
-
-      // convert to meter (SI units)
-      auto depthSI = depth * 0.001f;
-
-      auto x = (pixel_x - mSPtrCameraInfo->K.at(2)) / mSPtrCameraInfo->K.at(0);
-      auto y = (pixel_y - mSPtrCameraInfo->K.at(5)) / mSPtrCameraInfo->K.at(4);
-
-      point[0] = depthSI * x;
-      point[1] = depthSI * y;
-      point[2] = depthSI;
+      const auto count = keypoints.getVolume() / 3;
+      points.resize(count);
+      if (count > 0)
+        liftKeypoints(depthImage, keypoints.getConstPtr(), count, points);
     }
   };
 }
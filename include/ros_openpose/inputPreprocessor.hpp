@@ -0,0 +1,60 @@
+/**
+* inputPreprocessor.hpp: header file for InputPreprocessor. the preprocessor converts the color
+*                        image to bgr8 and scales it down before it is handed over to openpose.
+*                        it runs on the gpu if ros_openpose is built with cuda support
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// OpenCV headers
+#include <opencv2/core/core.hpp>
+#ifdef ROS_OPENPOSE_WITH_CUDA
+#include <opencv2/core/cuda.hpp>
+#endif
+
+// c++ headers
+#include <string>
+
+namespace ros_openpose
+{
+  // the options of the preprocessor
+  struct PreprocessOptions
+  {
+    // convert and scale the images on the gpu. the camera readers then share the color images in
+    // their original encoding, i.e., cv_bridge does not convert them on the cpu
+    bool gpu = false;
+
+    // the images taller than that (in pixels) are scaled down to it, keeping the aspect ratio.
+    // setting it to the height of the net resolution spares openpose its own resize. 0 keeps the size
+    int inputHeight = 0;
+  };
+
+  // the preprocessor of a single camera. it is used by the input worker only
+  class InputPreprocessor
+  {
+  private:
+    const PreprocessOptions mOptions;
+
+#ifdef ROS_OPENPOSE_WITH_CUDA
+    // the images are uploaded once and stay on the gpu until the prepared image is downloaded
+    cv::cuda::GpuMat mGpuImage, mGpuResized, mGpuConverted;
+    cv::cuda::Stream mStream;
+#endif
+
+  public:
+    InputPreprocessor(const PreprocessOptions& options);
+
+    // returns true if ros_openpose is built with cuda support and a cuda device is found
+    static bool gpuAvailable();
+
+    // returns true if the given encoding of the color image can be converted by the preprocessor,
+    // i.e., bgr8, rgb8, bgra8, rgba8 or mono8
+    static bool supportsEncoding(const std::string& encoding);
+
+    // returns the image handed over to openpose, i.e., the given image in bgr8 encoding and scaled
+    // down to the input height. the keypoints found by openpose are relative to the returned image.
+    // the image is shared (not copied) if it needs neither a conversion nor scaling
+    cv::Mat prepare(const cv::Mat& image, const std::string& encoding);
+  };
+}
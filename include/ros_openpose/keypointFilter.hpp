@@ -0,0 +1,94 @@
+/**
+* keypointFilter.hpp: header file for KeypointFilter. the filter smooths the keypoints of each
+*                     tracked person in 3D space (wrt camera coordinate system) over time. its
+*                     state is preallocated, i.e., no memory is allocated per frame
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// ROS headers
+#include <ros/ros.h>
+
+// ros_openpose headers
+#include <ros_openpose/cameraReader.hpp>
+
+// c++ headers
+#include <array>
+#include <string>
+#include <vector>
+
+namespace ros_openpose
+{
+  // the filters for smoothing the keypoints. each axis of a keypoint is filtered on its own
+  enum class FilterType
+  {
+    None,
+    OneEuro,  // low-pass filter whose cutoff frequency grows with the speed of the keypoint
+    Kalman    // kalman filter with a constant velocity model
+  };
+
+  // converts the name of a filter, i.e., none, one_euro or kalman, to its value.
+  // returns false if the name is unknown
+  bool stringToFilterType(const std::string& name, FilterType& filterType);
+
+  // the options of the filter
+  struct FilterOptions
+  {
+    FilterType type = FilterType::None;
+
+    // the number of persons whose state is kept. the state of the person seen least recently is
+    // dropped once there are more
+    int capacity = 64;
+
+    // the one euro filter. src: https://cristal.univ-lille.fr/~casiez/1euro/
+    double minCutoff = 1.0;         // cutoff frequency (in Hz) at rest
+    double beta = 5.0;              // growth of the cutoff frequency with the speed (in s/m)
+    double derivativeCutoff = 1.0;  // cutoff frequency (in Hz) of the speed
+
+    // the kalman filter
+    double processNoise = 2.0;       // standard deviation of the acceleration (in m/s^2)
+    double measurementNoise = 0.02;  // standard deviation of the lifted keypoints (in meters)
+  };
+
+  // smooths the keypoints of the persons of a single camera. the state of each person is found by its
+  // track id. the states of all the persons are stored in a single buffer, one slot per person
+  class KeypointFilter
+  {
+  public:
+    KeypointFilter(const FilterOptions& options = FilterOptions());
+
+    // filters the valid keypoints of the tracked persons in place. the keypoints of the person 'i' are
+    // found at 'offsets[k] + i * partCounts[k]' for each of the keypoint arrays 'k', i.e., body, face
+    // and hands. the persons which are not tracked, i.e., with id -1, are left untouched
+    void apply(Keypoints3D& keypoints, const std::array<size_t, 4>& offsets, const std::array<int, 4>& partCounts,
+               const std::vector<int>& ids, const ros::Time& stamp);
+
+  private:
+    // the state of a single keypoint. the one euro filter uses the value and its rate, the kalman
+    // filter additionally uses the covariance of the position and the velocity
+    struct KeypointState
+    {
+      float value[3], rate[3];
+      float p00[3], p01[3], p11[3];
+      double time;
+      bool initialized;
+    };
+
+    // finds the slot of the given person. a new slot is taken for a person seen the first time
+    size_t findSlot(const int id);
+
+    void oneEuro(KeypointState& state, const float (&value)[3], const float dt) const;
+    void kalman(KeypointState& state, const float (&value)[3], const float dt) const;
+
+    FilterOptions mOptions;
+
+    // the states of the keypoints of each slot are stored one after another
+    std::vector<KeypointState> mStates;
+    size_t mPartsPerPerson = 0;
+
+    // the id of the person occupying each slot (-1 if free) and the time it was seen last
+    std::vector<int> mSlotIds;
+    std::vector<double> mSlotTimes;
+  };
+}
@@ -0,0 +1,56 @@
+/**
+* motionDetector.hpp: header file for MotionDetector. the motion detector compares a downsampled
+*                     version of the color image with the one of the last frame processed by
+*                     openpose. the inference of a frame is skipped if nothing has changed
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// OpenCV headers
+#include <opencv2/core/core.hpp>
+
+namespace ros_openpose
+{
+  // the options of the motion detector
+  struct MotionOptions
+  {
+    bool enabled = false;
+
+    // the width (in pixels) of the downsampled image. the height keeps the aspect ratio
+    int width = 80;
+
+    // the smallest difference of the gray level of a pixel which counts as motion
+    double pixelThreshold = 15.0;
+
+    // the fraction of the pixels which have to change for the frame to be processed
+    double areaThreshold = 0.01;
+
+    // a frame is processed after this many skipped frames, even if nothing has changed
+    int maxSkippedFrames = 30;
+  };
+
+  // the motion detector of a single camera. it is used by the input worker only
+  class MotionDetector
+  {
+  private:
+    const MotionOptions mOptions;
+
+    // the downsampled gray image of the last frame processed by openpose
+    cv::Mat mReference;
+
+    // buffers reused across frames
+    cv::Mat mSmall, mGray, mDifference;
+
+    // the number of frames skipped since the last processed frame
+    int mSkippedFrames = 0;
+
+  public:
+    MotionDetector(const MotionOptions& options);
+
+    // returns true if the given color image (3 or 4 channels, or gray) has to be processed by openpose,
+    // i.e., the motion detector is disabled, something has changed since the last processed frame or
+    // too many frames were skipped. the image then becomes the reference for the next frames
+    bool shouldProcess(const cv::Mat& colorImage);
+  };
+}
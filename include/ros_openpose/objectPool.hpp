@@ -0,0 +1,66 @@
+/**
+* objectPool.hpp: header file for ObjectPool. the pool hands out shared objects which are reused once
+*                 nobody else holds them anymore, so that no memory is allocated per frame
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// c++ headers
+#include <atomic>
+#include <vector>
+
+namespace ros_openpose
+{
+  // a pool of objects held by shared pointers, e.g., std::shared_ptr or boost::shared_ptr. an object is
+  // free once the pool is its only owner, hence the objects need not be given back. they are released on
+  // any thread, but the pool itself is used by a single thread. the objects keep their contents, e.g., the
+  // capacity of their vectors, hence the user must overwrite whatever it reads afterwards
+  template <typename Ptr>
+  class ObjectPool
+  {
+  private:
+    typedef typename Ptr::element_type T;
+
+    std::vector<Ptr> mObjects;
+
+    // the objects are checked round-robin, the oldest ones are the most likely to be free
+    size_t mNext = 0;
+
+  public:
+    // creates 'count' objects up front
+    explicit ObjectPool(const size_t count = 0)
+    {
+      mObjects.reserve(count);
+      for (size_t i = 0; i < count; i++)
+        mObjects.emplace_back(new T());
+    }
+
+    // returns an object which nobody else holds. a new one is created only if all of them are in use,
+    // the pool thus grows up to the number of objects in flight
+    Ptr acquire()
+    {
+      for (size_t i = 0; i < mObjects.size(); i++)
+      {
+        const auto& object = mObjects[mNext];
+        mNext = (mNext + 1) % mObjects.size();
+        if (object.use_count() == 1)
+        {
+          // the last owner released the object with an acquire-release decrement. the fence makes its
+          // writes to the object visible to us before we reuse it
+          std::atomic_thread_fence(std::memory_order_acquire);
+          return object;
+        }
+      }
+
+      mObjects.emplace_back(new T());
+      return mObjects.back();
+    }
+
+    // the number of objects created so far
+    size_t size() const
+    {
+      return mObjects.size();
+    }
+  };
+}
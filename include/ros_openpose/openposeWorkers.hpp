@@ -0,0 +1,416 @@
+/**
+* openposeWorkers.hpp: header file for the custom datum and the workers of the openpose wrapper.
+*                      the input worker provides the color images of one or more cameras to the
+*                      openpose wrapper. the output worker receives the keypoints detected in 2D
+*                      space and converts them to 3D coordinates (wrt camera coordinate system)
+* Author: Ravi Joshi
+* Date: 2019/09/27
+* src: https://github.com/CMU-Perceptual-Computing-Lab/openpose/tree/master/examples/tutorial_api_cpp
+*/
+
+#pragma once
+
+// ROS headers
+#include <diagnostic_updater/DiagnosticStatusWrapper.h>
+#include <ros/ros.h>
+
+// ros_openpose headers
+#include <ros_openpose/Frame.h>
+#include <ros_openpose/Latency.h>
+#include <ros_openpose/PackedFrame.h>
+#include <ros_openpose/PipelineStats.h>
+#include <ros_openpose/cameraReader.hpp>
+#include <ros_openpose/inputPreprocessor.hpp>
+#include <ros_openpose/keypointFilter.hpp>
+#include <ros_openpose/motionDetector.hpp>
+#include <ros_openpose/objectPool.hpp>
+#include <ros_openpose/personTracker.hpp>
+#include <ros_openpose/pipelineProfiler.hpp>
+#include <ros_openpose/qualityController.hpp>
+#include <ros_openpose/regionOfInterest.hpp>
+#include <ros_openpose/skeletonPublisher.hpp>
+#include <ros_openpose/subscriberMonitor.hpp>
+
+// OpenPose headers
+#include <openpose/headers.hpp>
+
+// c++ headers
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ros_openpose
+{
+  // custom datum. openpose reads the color image directly from the memory of the ros
+  // message, therefore the datum holds the messages until openpose is done with them.
+  // the datum also carries the timestamps needed for the latency report
+  struct RosDatum : public op::Datum
+  {
+    cv_bridge::CvImageConstPtr colorImagePtr;
+
+    // the depth image synchronized with the color image. the keypoints are lifted with it
+    cv_bridge::CvImageConstPtr depthImagePtr;
+
+    // header of the color image. the stamp is the time of capture
+    std_msgs::Header header;
+
+    // time at which the image callback received the frame and the time at which it handed the frame over,
+    // i.e., after converting the images
+    ros::Time callbackTime, readyTime;
+
+    // time at which the input worker took the frame and the time it spent on preparing the color image for
+    // openpose. the frame was handed over to openpose afterwards
+    ros::Time producerTime;
+    ros::Duration preprocessing;
+
+    // number of the batch among the ones handed over to openpose, warmup batches included, and the time the
+    // batch was handed over, i.e., once the frames of all the cameras were prepared
+    unsigned long long batchNumber = 0;
+    ros::Time handoffTime;
+
+    // time at which the batch reached the output worker and the part of it openpose spent on the batch, i.e.,
+    // without the time the batch waited for a gpu. openpose runs the network and the association of the body
+    // parts on the same thread, so they are not told apart
+    ros::Time outputTime;
+    ros::Duration inference;
+
+    // sequence number of the batch the datum belongs to. it is assigned by the input
+    // worker and restores the order of the batches if several gpus run in parallel
+    unsigned long long sequence = 0;
+
+    // the part of the color image handed over to openpose. the keypoints are found relative to it,
+    // scaled by the size of 'cvInputData' if the preprocessor scaled the part down
+    cv::Rect roi;
+
+    // the frame bypassed openpose since nothing has changed. the output worker publishes the
+    // persons of the last processed frame again
+    bool skipped = false;
+
+    // a synthetic frame warming openpose up. the output worker does not publish it
+    bool warmup = false;
+
+    // sets the fields of ros_openpose back, so that a datum of the pool can take the next frame. the outputs of
+    // openpose are overwritten by openpose itself, as the pools live only as long as its configuration. the
+    // header is overwritten along with the images, keeping the memory of its frame id
+    void recycle()
+    {
+      releaseImages();
+      callbackTime = readyTime = producerTime = handoffTime = outputTime = ros::Time();
+      preprocessing = inference = ros::Duration();
+      batchNumber = sequence = 0;
+      roi = cv::Rect();
+      skipped = warmup = false;
+    }
+
+    // lets go of the images once the frame is published, so that an idle datum of the pool does not keep
+    // the messages of the camera alive
+    void releaseImages()
+    {
+      colorImagePtr.reset();
+      depthImagePtr.reset();
+      cvInputData = cv::Mat();
+    }
+  };
+
+  // define a few datatype
+  typedef std::shared_ptr<RosDatum> sPtrDatum;
+  typedef std::shared_ptr<std::vector<sPtrDatum>> sPtrVecSPtrDatum;
+  typedef op::WrapperT<RosDatum> Wrapper;
+
+  // the publishers of the output worker. a publisher which is not advertised disables its output
+  struct OutputPublishers
+  {
+    ros::Publisher frame;
+    ros::Publisher packedFrame;
+    ros::Publisher latency;
+
+    // optionally receives every frame along with the frame publisher, e.g., for writing it into a bag.
+    // it is invoked on the thread of the output worker
+    std::function<void(const ros_openpose::Frame&)> frameSink;
+  };
+
+  // the order in which the output worker publishes the batches. with several gpus, a batch
+  // may overtake the ones handed over to openpose before it
+  enum class OutputOrder
+  {
+    DropLate,  // a batch waits a bounded time for the older ones, the batches arriving later are dropped
+    Strict     // every batch is published, in the order in which it was handed over to openpose
+  };
+
+  // converts the name of an output order, i.e., drop_late or strict, to its value.
+  // returns false if the name is unknown
+  bool stringToOutputOrder(const std::string& name, OutputOrder& outputOrder);
+
+  // the options of the output worker
+  struct OutputOptions
+  {
+    OutputOrder order = OutputOrder::DropLate;
+
+    // the longest time (in seconds) a batch waits for the older ones with the drop late order
+    double reorderTimeout = 0.1;
+
+    // the options of the tracker assigning the ids to the persons. the tracker of each camera is created
+    // with them once, see Camera
+    TrackerOptions tracker;
+
+    // the options of the filter smoothing the keypoints of the tracked persons, also created once per camera
+    FilterOptions filter;
+
+    // the number of persons the messages reserve room for up front, i.e., --number_people_max. -1 reserves
+    // nothing, the messages grow with the number of persons seen instead
+    int numberPeopleMax = -1;
+
+    // the number of gpus openpose runs on, i.e., the number of batches it works on at the same time
+    unsigned int gpuCount = 1;
+  };
+
+  // what happens to the frames if openpose is slower than the cameras
+  enum class DropPolicy
+  {
+    Latest,  // the input worker waits for room in the pipeline and takes the newest frames, the older ones are dropped
+    Queue    // the frames queue up inside openpose. the input worker blocks while the queues are full
+  };
+
+  // converts the name of a drop policy, i.e., latest or queue, to its value.
+  // returns false if the name is unknown
+  bool stringToDropPolicy(const std::string& name, DropPolicy& dropPolicy);
+
+  // the state of the pipeline between the input and the output worker. the counters of the
+  // input worker are kept here, the output worker publishes them along with its own ones
+  struct PipelineState
+  {
+    DropPolicy dropPolicy = DropPolicy::Latest;
+
+    // the largest number of batches inside openpose. 0 means no limit
+    unsigned int depth = 0;
+
+    // optional publisher of the counters, see PipelineStats.msg
+    ros::Publisher statsPublisher;
+
+    // the percentiles of the stage durations, the achieved rate and the gpu memory. the output worker fills
+    // them once per second if 'diagnostics' is set, the diagnostic updater of the node reports them. the
+    // status is guarded by the mutex below
+    bool diagnostics = false;
+    diagnostic_updater::DiagnosticStatusWrapper diagnosticStatus;
+
+    // optional controller of the quality presets. it is given the inference time of each batch
+    std::shared_ptr<QualityController> qualityController;
+
+    // signalled by the output worker whenever a batch leaves openpose
+    std::mutex mutex;
+    std::condition_variable condition;
+    unsigned long long batchesProduced = 0, batchesConsumed = 0;
+    unsigned long long framesProcessed = 0, framesDroppedAtInput = 0, framesSkipped = 0;
+
+    // the batches of the frames which bypass openpose. they are handed over to the output
+    // worker directly
+    std::vector<sPtrVecSPtrDatum> skippedBatches;
+
+    // the number of synthetic batches of the given size the input worker feeds to openpose before the
+    // first frame of the cameras. they let caffe load the weights and cudnn pick its algorithms. the
+    // output worker invokes the callback with the number of warmup batches which left openpose so far
+    unsigned int warmupFrames = 0;
+    cv::Size warmupSize;
+    std::function<void(unsigned int)> warmupCallback;
+  };
+
+  // a camera feeding the openpose wrapper, along with the publishers of its results
+  struct Camera
+  {
+    std::shared_ptr<CameraReader> cameraReader;
+    std::shared_ptr<RegionOfInterest> regionOfInterest;
+    std::shared_ptr<MotionDetector> motionDetector;
+    std::shared_ptr<InputPreprocessor> inputPreprocessor;
+    std::shared_ptr<SkeletonPublisher> skeletonPublisher;
+    std::shared_ptr<SubscriberMonitor> subscriberMonitor;
+
+    // the tracks and the smoothed keypoints outlive the output worker, so that a restart of the wrapper
+    // neither renumbers the persons nor resets the filter
+    std::shared_ptr<PersonTracker> personTracker;
+    std::shared_ptr<KeypointFilter> keypointFilter;
+
+    OutputPublishers publishers;
+    std::string frameId;
+  };
+
+  // the input worker. the job of this worker is to provide color imagees to
+  // openpose wrapper. the frames of all the cameras are packed into one batch, one
+  // datum per camera. the index of the camera is stored in the 'subId' of the datum
+  class WUserInput : public op::WorkerProducer<sPtrVecSPtrDatum>
+  {
+  public:
+    WUserInput(const std::vector<Camera>& cameras, const std::shared_ptr<PipelineState>& sPtrPipelineState);
+
+    void initializationOnThread()
+    {
+    }
+
+    sPtrVecSPtrDatum workProducer();
+
+  private:
+    const std::vector<Camera> mCameras;
+
+    // raised by any of the camera readers whenever it receives a new frame
+    const std::shared_ptr<FrameSignal> mSPtrFrameSignal;
+    unsigned long long mSignalCount = 0;
+
+    // number of the latest frame of each camera handed over to openpose
+    std::vector<unsigned long long> mFrameNumbers;
+
+    // sequence number of the next batch
+    unsigned long long mSequence = 0;
+
+    // number of the next batch handed over to openpose, see RosDatum::batchNumber
+    unsigned long long mBatchNumber = 0;
+
+    // stamps the datums of a batch which is handed over to openpose
+    void handOver(const sPtrVecSPtrDatum& datumsPtr);
+
+    const std::shared_ptr<PipelineState> mSPtrPipelineState;
+
+    // the warmup batches which are yet to be handed over to openpose
+    unsigned int mWarmupRemaining;
+
+    // the datums and the batches return to the pools once openpose, the output worker and the reorder
+    // buffer let go of them. nothing is allocated per frame once the pools hold as many as are in flight
+    ObjectPool<sPtrDatum> mDatumPool;
+    ObjectPool<sPtrVecSPtrDatum> mBatchPool;
+
+    // takes an empty datum and an empty batch from the pools
+    sPtrDatum acquireDatum();
+    sPtrVecSPtrDatum acquireBatch();
+
+    // creates a batch of synthetic frames, one per camera
+    sPtrVecSPtrDatum createWarmupBatch();
+  };
+
+  // the outpout worker. the job of the output worker is to receive the keypoints
+  // detected in 2D space. it then converts 2D pixels to 3D coordinates (wrt
+  // camera coordinate system). the results of each camera are published on its own topics
+  class WUserOutput : public op::WorkerConsumer<sPtrVecSPtrDatum>
+  {
+  public:
+    WUserOutput(const std::vector<Camera>& cameras, const OutputOptions& outputOptions,
+                const std::shared_ptr<PipelineState>& sPtrPipelineState);
+
+    void initializationOnThread()
+    {
+    }
+
+    void workConsumer(const sPtrVecSPtrDatum& datumsPtr);
+
+  private:
+    // the output of a camera. the messages are reused across frames
+    struct CameraOutput
+    {
+      Camera camera;
+
+      // the header of the current frame. the frame id is set once
+      std_msgs::Header header;
+
+      // the frames are published as shared pointers, so that the subscribers in the same process, e.g., the
+      // nodelets, get them without a copy. a published message must not change anymore, hence each frame is
+      // filled into a message of the pool which nobody holds. the last messages are kept for republishing
+      // them, they are null if they do not hold the persons of the last processed frame
+      ObjectPool<ros_openpose::FramePtr> framePool;
+      ObjectPool<ros_openpose::PackedFramePtr> packedFramePool;
+      ros_openpose::FramePtr frame;
+      ros_openpose::PackedFramePtr packedFrame;
+      ros_openpose::Latency latency;
+
+      // the persons removed from a message as the number of persons dropped. they keep the memory of their
+      // parts for the next message needing more persons
+      std::vector<ros_openpose::Person> sparePersons;
+
+      // the ids the tracker of the camera assigned to the persons of the current frame
+      std::vector<int> personIds;
+    };
+
+    // a batch which arrived before the older ones, i.e., before the ones with a lower sequence number
+    struct PendingBatch
+    {
+      unsigned long long sequence;
+      sPtrVecSPtrDatum datums;
+      ros::WallTime arrivalTime;
+    };
+
+    // stamps the datums of a batch which left openpose with the time openpose spent on it. a batch
+    // starts once it was handed over and once a gpu is free, i.e., once the batch 'gpuCount' before it left
+    void stampInference(const sPtrVecSPtrDatum& datumsPtr);
+
+    // adds the batch to the reorder buffer. it is dropped if a newer batch was published already
+    void addPendingBatch(const sPtrVecSPtrDatum& datumsPtr);
+
+    // publishes the pending batches in the order of their sequence numbers. a missing batch is
+    // skipped once the wait for it is over, see OutputOptions
+    void flushPendingBatches();
+
+    // publishes the datums of the batch, each on the topics of its camera
+    void publishBatch(const sPtrVecSPtrDatum& datumsPtr);
+
+    // lets go of the images of the datums of the batch, see RosDatum::releaseImages()
+    static void releaseBatch(const sPtrVecSPtrDatum& datumsPtr);
+
+    // resizes the persons of the message. the persons beyond the new size are moved to the spare ones rather
+    // than destroyed, and moved back when more persons are needed, so that their parts keep their memory
+    static void resizePersons(std::vector<ros_openpose::Person>& persons, const size_t count,
+                              std::vector<ros_openpose::Person>& sparePersons);
+
+    // publishes the counters of the pipeline and updates the diagnostics once per second
+    void publishStatistics();
+    void updateDiagnostics(const double period);
+
+    // lifts the keypoints of the datum to 3D space and publishes them on the topics of the camera
+    void publishDatum(const RosDatum& datum, CameraOutput& output);
+
+    // publishes the persons of the last processed frame again, with the stamp of the skipped datum
+    void republishDatum(const RosDatum& datum, CameraOutput& output);
+
+    // fills the parts of the given person from the keypoints detected in 2D space and their points
+    // in 3D space. 'offset' is the position of the first keypoint of 'keypoints' in the lifted buffer
+    void fillBodyParts(std::vector<ros_openpose::BodyPart>& parts, const op::Array<float>& keypoints,
+                       const size_t offset, const int person);
+
+    // fills the packed frame. the keypoints of each person are placed one after another
+    // in the order of the layout, i.e., body, face, left hand and right hand
+    void fillPackedFrame(ros_openpose::PackedFrame& packedFrame,
+                         const std::array<const op::Array<float>*, 4>& keypointArrays,
+                         const std::array<size_t, 4>& offsets, const int personCount);
+
+    std::vector<CameraOutput> mOutputs;
+
+    // the reorder buffer, sorted by the sequence numbers. the batches are published in this order. the
+    // batches mostly arrive in order, hence they are appended to it and taken from its front
+    const OutputOptions mOutputOptions;
+    std::vector<PendingBatch> mPendingBatches;
+
+    // the batches of the skipped frames taken from the pipeline state. the vectors are swapped, hence both
+    // of them keep their memory
+    std::vector<sPtrVecSPtrDatum> mSkippedBatches;
+    unsigned long long mNextSequence = 0;
+
+    // the counters of the output worker. the remaining ones are found in the pipeline state
+    const std::shared_ptr<PipelineState> mSPtrPipelineState;
+    unsigned long long mFramesDroppedAtOutput = 0, mFramesPublished = 0;
+    unsigned int mWarmupArrived = 0;
+    ros_openpose::PipelineStats mPipelineStats;
+    ros::WallTime mLastStatsTime;
+
+    // the times at which the last 'gpuCount' batches left openpose, in a ring buffer indexed by the number of
+    // batches which left openpose so far
+    std::vector<ros::Time> mBatchEndTimes;
+    unsigned long long mBatchesArrived = 0;
+
+    // the stage durations of the processed frames and the counters at the time of the last report
+    PipelineProfiler mProfiler;
+    unsigned long long mLastFramesReceived = 0, mLastFramesPublished = 0;
+    diagnostic_updater::DiagnosticStatusWrapper mDiagnosticStatus;
+
+    // the keypoints in 3D space. the buffers are reused across frames and cameras
+    Keypoints3D mKeypoints3D;
+  };
+}
@@ -0,0 +1,90 @@
+/**
+* personTracker.hpp: header file for PersonTracker. the tracker associates the persons found in
+*                    a frame with the ones found in the previous frames, so that each person keeps
+*                    its id. the association is done in 3D space (wrt camera coordinate system)
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// ros_openpose headers
+#include <ros_openpose/cameraReader.hpp>
+
+// c++ headers
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ros_openpose
+{
+  // the options of the tracker
+  struct TrackerOptions
+  {
+    bool enabled = true;
+
+    // the largest distance (in meters) between a person and a track for being associated
+    double maxDistance = 0.5;
+
+    // a track is removed once it was not seen in this many frames
+    int maxMissedFrames = 5;
+  };
+
+  // tracks the persons of a single camera. the persons are associated greedily, the closest pairs
+  // first. the tracks are looked up in a grid of cells as large as the distance threshold, hence
+  // the cost grows linearly with the number of persons instead of quadratically
+  class PersonTracker
+  {
+  public:
+    PersonTracker(const TrackerOptions& options = TrackerOptions());
+
+    // assigns the ids to the persons found in a frame. the body keypoints of the person 'i' are found at
+    // 'offset + i * partCount' in the lifted keypoints. the id is -1 if the person can not be tracked,
+    // i.e., none of its keypoints has a valid depth, or if the tracker is disabled
+    void update(const Keypoints3D& keypoints, const size_t offset, const int personCount, const int partCount,
+                std::vector<int>& ids);
+
+  private:
+    struct Track
+    {
+      int id;
+      int missedFrames;
+      std::array<float, 3> centroid;
+
+      // the body keypoints of the person at the time it was seen
+      std::vector<float> x, y, z;
+      std::vector<unsigned char> valid;
+    };
+
+    // a possible association of a person with a track
+    struct Candidate
+    {
+      float distance;
+      int person, track;
+    };
+
+    // computes the centroid of the valid keypoints of a person. returns false if there is none
+    static bool computeCentroid(const Keypoints3D& keypoints, const size_t first, const int partCount,
+                                std::array<float, 3>& centroid);
+
+    // the mean distance between the keypoints which are valid for both, the person and the track.
+    // the distance of the centroids is used if they have no such keypoint in common
+    static float distance(const Track& track, const Keypoints3D& keypoints, const size_t first, const int partCount,
+                          const std::array<float, 3>& centroid);
+
+    // the key of the given grid cell and the cell containing the given point
+    static int64_t cellKey(const int cellX, const int cellY, const int cellZ);
+    std::array<int, 3> cellOf(const std::array<float, 3>& point) const;
+
+    TrackerOptions mOptions;
+    std::vector<Track> mTracks;
+    int mNextId = 0;
+
+    // buffers reused across frames
+    std::unordered_map<int64_t, std::vector<int>> mGrid;
+    std::vector<Candidate> mCandidates;
+    std::vector<std::array<float, 3>> mCentroids;
+    std::vector<unsigned char> mHasCentroid, mTrackMatched;
+    std::vector<int> mPersonTracks;
+  };
+}
@@ -0,0 +1,72 @@
+/**
+* pipelineProfiler.hpp: header file for PipelineProfiler. the profiler keeps the durations of the stages
+*                       of the last frames and reports their percentiles as ros diagnostics
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// ROS headers
+#include <diagnostic_msgs/DiagnosticStatus.h>
+
+// c++ headers
+#include <array>
+#include <string>
+#include <vector>
+
+namespace ros_openpose
+{
+  // the stages a frame passes through, from the camera until it is published
+  enum class Stage
+  {
+    Sync,           // camera stamp -> image callback (transport and synchronization)
+    Conversion,     // image callback: converting the color image and sharing the depth image
+    ProducerWait,   // image callback -> input worker
+    Preprocessing,  // input worker: cropping, converting and scaling the color image for openpose
+    Queue,          // preprocessed -> openpose (the other cameras of the batch, waiting for a free gpu)
+    Inference,      // openpose (network forward, nms and paf association)
+    Reorder,        // openpose -> output worker (reorder buffer, the previous cameras of the batch)
+    Lifting,        // output worker: 2D -> 3D lifting, tracking and filtering of the keypoints
+    Publish,        // output worker: filling and serializing the messages
+    Total           // camera stamp -> frame published
+  };
+
+  const size_t STAGE_COUNT = 10;
+
+  // the rolling percentiles of the duration of each stage. it is used by a single thread, i.e., the
+  // output worker, hence it needs no locking
+  class PipelineProfiler
+  {
+  public:
+    // the percentiles are taken over the last 'windowSize' frames
+    PipelineProfiler(const size_t windowSize = 300);
+
+    // adds the duration (in seconds) of a stage of a frame
+    void addSample(const Stage stage, const double duration);
+
+    // appends the p50, p95 and p99 (in milliseconds) of each stage to the values of the status
+    void fillStatus(diagnostic_msgs::DiagnosticStatus& status);
+
+    // appends the memory used on each gpu (in megabytes) to the values of the status. it needs ros_openpose
+    // built with WITH_CUDA_PREPROCESSING, returns false otherwise
+    static bool fillGpuMemory(diagnostic_msgs::DiagnosticStatus& status);
+
+    // the hardware the diagnostics are reported for, i.e., the names of the gpus if ros_openpose is built with
+    // WITH_CUDA_PREPROCESSING, 'openpose' otherwise
+    static std::string hardwareId();
+
+  private:
+    static const char* stageName(const size_t stage);
+
+    struct Window
+    {
+      std::vector<double> samples;
+      size_t count = 0;
+    };
+
+    std::array<Window, STAGE_COUNT> mWindows;
+
+    // the samples are sorted here, so that no memory is allocated per report
+    std::vector<double> mSorted;
+  };
+}
@@ -0,0 +1,57 @@
+/**
+* poseSettings.hpp: header file for the pose settings. they are the parameters of openpose which
+*                   can be changed while ros_openpose is running, along with the quality presets
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// c++ headers
+#include <string>
+#include <vector>
+
+namespace ros_openpose
+{
+  // the parameters of the pose estimation, i.e., --net_resolution, --scale_number, --scale_gap
+  // and --number_people_max. changing any of them needs the openpose wrapper to be restarted
+  struct PoseSettings
+  {
+    std::string netResolution = "-1x368";
+    int scaleNumber = 1;
+    double scaleGap = 0.25;
+    int numberPeopleMax = -1;
+
+    PoseSettings() = default;
+
+    PoseSettings(const std::string& netResolution, const int scaleNumber, const double scaleGap,
+                 const int numberPeopleMax)
+      : netResolution(netResolution), scaleNumber(scaleNumber), scaleGap(scaleGap), numberPeopleMax(numberPeopleMax)
+    {
+    }
+
+    bool operator==(const PoseSettings& other) const
+    {
+      return netResolution == other.netResolution && scaleNumber == other.scaleNumber &&
+             scaleGap == other.scaleGap && numberPeopleMax == other.numberPeopleMax;
+    }
+
+    bool operator!=(const PoseSettings& other) const
+    {
+      return !(*this == other);
+    }
+  };
+
+  // the quality presets, from the fastest to the most accurate one. they set the resolution and the
+  // scales only, i.e., 'numberPeopleMax' is left as it is. keep them in sync with cfg/RosOpenpose.cfg
+  const std::vector<PoseSettings>& qualityPresets();
+
+  // applies the quality preset at the given index to the settings. returns false if there is no such preset
+  bool applyQualityPreset(const int quality, PoseSettings& settings);
+
+  // the cost of the inference relative to other settings. it grows with the area of the network input
+  // and with the number of scales. an unknown width ('-1') is taken as wide as the height
+  double relativeCost(const PoseSettings& settings);
+
+  // returns the index of the quality preset whose cost is closest to the one of the given settings
+  int closestQualityPreset(const PoseSettings& settings);
+}
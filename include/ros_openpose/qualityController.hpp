@@ -0,0 +1,69 @@
+/**
+* qualityController.hpp: header file for QualityController. the controller steps through the quality
+*                        presets of openpose, so that the inference time stays within a budget while
+*                        the available compute changes
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// ros_openpose headers
+#include <ros_openpose/poseSettings.hpp>
+
+// c++ headers
+#include <mutex>
+#include <vector>
+
+namespace ros_openpose
+{
+  // the options of the controller
+  struct AdaptiveOptions
+  {
+    bool enabled = false;
+
+    // the budget of the inference time is the smaller one of the frame period (1 / fps) and the latency
+    // (in seconds). zero disables either of them
+    double targetFps = 0.0;
+    double targetLatency = 0.0;
+
+    // the quality is stepped down once the median inference time exceeds 'downThreshold' times the budget,
+    // and stepped up once the time expected with the next preset is below 'upThreshold' times the budget.
+    // the gap between them keeps the quality from oscillating
+    double downThreshold = 1.0;
+    double upThreshold = 0.8;
+
+    // the number of batches the median is taken over
+    int windowSize = 30;
+
+    // the least time (in seconds) between two changes, as each of them restarts openpose
+    double holdTime = 30.0;
+
+    // the range of the quality presets the controller may use
+    int minQuality = 0;
+    int maxQuality = 4;
+  };
+
+  // the samples are added by the output worker, the quality is updated by a timer of the node
+  class QualityController
+  {
+  private:
+    const AdaptiveOptions mOptions;
+
+    // the inference times of the last batches, in a ring buffer
+    std::vector<double> mSamples, mSorted;
+    size_t mSampleCount = 0;
+    std::mutex mMutex;
+
+    double mLastChangeTime = 0.0;
+
+  public:
+    QualityController(const AdaptiveOptions& options);
+
+    // adds the inference time (in seconds) of a batch
+    void addSample(const double inferenceTime);
+
+    // decides on the quality preset, given the settings openpose currently runs with and the current
+    // time (in seconds). returns true and sets 'quality' if openpose should be restarted with another preset
+    bool update(const PoseSettings& current, const double now, int& quality);
+  };
+}
@@ -0,0 +1,70 @@
+/**
+* regionOfInterest.hpp: header file for RegionOfInterest. the region of interest is the part of
+*                       the color image around the persons detected in the previous frames. only
+*                       this part is handed over to openpose, which reduces the size of the input
+*                       of the network
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// OpenCV headers
+#include <opencv2/core/core.hpp>
+
+// OpenPose headers
+#include <openpose/core/array.hpp>
+
+// c++ headers
+#include <mutex>
+
+namespace ros_openpose
+{
+  // the options of the region of interest
+  struct RoiOptions
+  {
+    bool enabled = false;
+
+    // a full frame is processed after this many cropped frames, so that new persons are found
+    int fullFrameInterval = 10;
+
+    // the margin added on each side of the bounding box of the persons, as a fraction of its size
+    double margin = 0.2;
+
+    // the smallest width and height (in pixels) of the region of interest
+    int minSize = 64;
+  };
+
+  // the region of interest of a single camera. it is updated by the output worker from the
+  // keypoints found in a frame and read by the input worker for cropping the next frame
+  class RegionOfInterest
+  {
+  private:
+    const RoiOptions mOptions;
+    std::mutex mMutex;
+
+    // the region of interest in full image coordinates. it is empty if there is no person
+    cv::Rect mRoi;
+
+    // the number of cropped frames since the last full frame
+    int mCroppedFrames = 0;
+
+    // the number of persons found in the last frame. a full frame is processed as soon as it drops
+    int mPersonCount = 0;
+
+  public:
+    RegionOfInterest(const RoiOptions& options);
+
+    // returns the part of the image to be handed over to openpose. it is the whole image if the
+    // region of interest is disabled, if there is no person or if a full frame is due
+    cv::Rect next(const cv::Size& imageSize);
+
+    // updates the region of interest from the body keypoints found in a frame. the keypoints must be
+    // in full image coordinates
+    void update(const op::Array<float>& poseKeypoints, const cv::Size& imageSize);
+
+    // maps the keypoints found in the given part of the image back to full image coordinates. 'inputSize'
+    // is the size of the image openpose got, which is smaller than the part if it was scaled down.
+    // the keypoints which were not detected, i.e., with zero score, are left untouched
+    static void toFullImage(op::Array<float>& keypoints, const cv::Rect& roi, const cv::Size& inputSize);
+  };
+}
@@ -0,0 +1,150 @@
+/**
+* rosOpenpose.hpp: header file for RosOpenpose. the RosOpenpose class ties the camera reader,
+*                  the openpose wrapper and its workers together. it is shared by the
+*                  standalone node and the nodelet
+* Author: Ravi Joshi
+* Date: 2019/09/27
+*/
+
+#pragma once
+
+// ROS headers
+#include <diagnostic_updater/diagnostic_updater.h>
+#include <dynamic_reconfigure/server.h>
+#include <ros/ros.h>
+#include <std_msgs/Bool.h>
+
+// ros_openpose headers
+#include <ros_openpose/RosOpenposeConfig.h>
+#include <ros_openpose/cameraReader.hpp>
+#include <ros_openpose/openposeWorkers.hpp>
+#include <ros_openpose/poseSettings.hpp>
+
+// boost headers
+#include <boost/thread/recursive_mutex.hpp>
+
+// c++ headers
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ros_openpose
+{
+  // reads the path of the openpose models from the parameter server and parses the standard
+  // openpose command-line arguments. returns false if 'openpose_model_dir' is missing
+  bool initOpenPoseFlags(const ros::NodeHandle& nh, const std::vector<std::string>& args);
+
+  // reads the options of the output worker, i.e., the order of the frames, the tracker and the filter
+  OutputOptions readOutputOptions(const ros::NodeHandle& nh);
+
+  // reads the method and the window size used for reading the depth of a keypoint
+  void readDepthSampling(const ros::NodeHandle& nh, DepthSampling& depthSampling, int& windowSize);
+
+  // configures the openpose wrapper using the command-line flags. the frames of all the
+  // cameras are fed to the same wrapper
+  // clang-format off
+  void configureOpenPose(Wrapper& opWrapper,
+                         const std::vector<Camera>& cameras,
+                         const OutputOptions& outputOptions,
+                         const std::shared_ptr<PipelineState>& pipelineState);
+  // clang-format on
+
+  class RosOpenpose
+  {
+  private:
+    std::vector<Camera> mCameras;
+    Wrapper mOpWrapper;
+
+    // the workers are created again with these whenever the wrapper is restarted
+    OutputOptions mOutputOptions;
+    std::shared_ptr<PipelineState> mSPtrPipelineState;
+
+    // serializes the restarts of the wrapper
+    mutable std::mutex mWrapperMutex;
+
+    // the pose settings can be changed with dynamic reconfigure, see cfg/RosOpenpose.cfg
+    boost::recursive_mutex mReconfigureMutex;
+    std::unique_ptr<dynamic_reconfigure::Server<RosOpenposeConfig>> mUPtrReconfigureServer;
+
+    void reconfigureCallback(RosOpenposeConfig& config, const uint32_t level);
+
+    // a restart loads the network again, which takes seconds. it runs on its own thread, so that the callbacks
+    // neither block the spinner nor each other. only the latest requested settings are kept
+    std::thread mRestartThread;
+    std::mutex mRestartMutex;
+    std::condition_variable mRestartCondition;
+    PoseSettings mRequestedSettings;
+    bool mRestartRequested = false;
+    bool mRestartRunning = false;
+    bool mRestartStopped = false;
+
+    void restartLoop();
+
+    // steps the quality presets to hold the inference time within a budget. it runs once per second, but not
+    // while a restart is pending or running. the new settings are handed to the restart thread
+    std::shared_ptr<QualityController> mSPtrQualityController;
+    ros::WallTimer mAdaptiveTimer;
+
+    void adaptiveCallback(const ros::WallTimerEvent& event);
+
+    // reports the status of the pipeline filled by the output worker on /diagnostics, see 'diagnostics'. the
+    // updater is driven by a timer of its own period
+    std::unique_ptr<diagnostic_updater::Updater> mUPtrDiagnosticUpdater;
+    ros::WallTimer mDiagnosticTimer;
+
+    void diagnosticTimerCallback(const ros::WallTimerEvent& event);
+    void diagnosticCallback(diagnostic_updater::DiagnosticStatusWrapper& status);
+
+    // tells whether openpose is running and warmed up, see 'ready' topic. the topic is latched, so that a
+    // late subscriber gets the current state as well
+    ros::Publisher mReadyPublisher;
+    void setReady(const bool ready);
+
+    // the times at which the wrapper was constructed, started and warmed up by its first frame. the
+    // startup time of each phase is logged with them
+    ros::WallTime mConstructionTime, mStartTime, mFirstWarmupTime;
+
+    // starts the wrapper, with the cameras paused until the warmup frames went through openpose. it
+    // expects the wrapper mutex to be locked
+    void startWrapper();
+
+    // invoked by the output worker whenever a warmup batch left openpose
+    void warmupCallback(const unsigned int warmupArrived);
+
+  public:
+    // we don't want to instantiate using deafult constructor
+    RosOpenpose() = delete;
+
+    // the wrapper can not be copied
+    RosOpenpose(const RosOpenpose& other) = delete;
+    RosOpenpose& operator=(const RosOpenpose& other) = delete;
+
+    // main constructor. the parameters are read from the given node handle, which is
+    // also used for subscribing to the camera and publishing the frames
+    RosOpenpose(ros::NodeHandle& nh);
+
+    // stops the wrapper if it is still running
+    ~RosOpenpose();
+
+    // starts the openpose wrapper. it returns immediately as the workers run on their own threads
+    void start();
+
+    // stops the openpose wrapper
+    void stop();
+
+    // returns the pose settings openpose runs with
+    PoseSettings getPoseSettings() const;
+
+    // restarts the openpose wrapper with the given pose settings if they differ from the current ones. the
+    // network is loaded again, but neither warmed up nor are the cameras paused, see 'warmup_frames'. the
+    // persons keep their ids and their filters. it blocks until the wrapper is running again
+    void applyPoseSettings(const PoseSettings& settings);
+
+    // hands the pose settings to the restart thread, which applies them as above. it returns immediately. a
+    // request which is still pending is replaced by this one
+    void requestPoseSettings(const PoseSettings& settings);
+  };
+}
@@ -0,0 +1,82 @@
+/**
+* skeletonPublisher.hpp: header file for SkeletonPublisher. the skeleton publisher draws the 3D
+*                        skeletons of the persons as rviz markers and publishes the lifted keypoints
+*                        as a point cloud. the messages are only built if someone listens to them
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// ROS headers
+#include <ros/ros.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <visualization_msgs/MarkerArray.h>
+
+// ros_openpose headers
+#include <ros_openpose/cameraReader.hpp>
+
+// c++ headers
+#include <array>
+#include <string>
+#include <vector>
+
+namespace ros_openpose
+{
+  // the options of the skeleton markers
+  struct SkeletonOptions
+  {
+    // thickness (in meters) of the lines of the skeleton
+    double lineWidth = 0.01;
+
+    // height (in meters) of the text showing the id of a person
+    double textSize = 0.2;
+  };
+
+  // the visualization of a single camera. it is used by the output worker only
+  class SkeletonPublisher
+  {
+  public:
+    SkeletonPublisher() = default;
+
+    // advertises the markers and the point cloud on the given topics. an empty topic disables its output.
+    // the status callback is invoked whenever a subscriber connects or disconnects
+    SkeletonPublisher(ros::NodeHandle& nh, const std::string& markersTopic, const std::string& cloudTopic,
+                      const SkeletonOptions& options = SkeletonOptions(),
+                      const ros::SubscriberStatusCallback& statusCallback = ros::SubscriberStatusCallback());
+
+    const ros::Publisher& getMarkersPublisher() const
+    {
+      return mMarkersPublisher;
+    }
+
+    const ros::Publisher& getCloudPublisher() const
+    {
+      return mCloudPublisher;
+    }
+
+    // publishes the persons of a frame. the keypoints are laid out as for KeypointFilter::apply(),
+    // i.e., those of the person 'i' are found at 'offsets[k] + i * partCounts[k]' for the keypoint
+    // arrays 'k' (body, face and hands). the skeleton is drawn from the body keypoints only
+    void publish(const std_msgs::Header& header, const Keypoints3D& keypoints, const std::array<size_t, 4>& offsets,
+                 const std::array<int, 4>& partCounts, const std::vector<int>& ids);
+
+    // publishes the messages of the last frame again with the given stamp, if they are up to date
+    void republish(const ros::Time& stamp);
+
+  private:
+    void fillMarkers(const std_msgs::Header& header, const Keypoints3D& keypoints, const size_t offset,
+                     const int partCount, const std::vector<int>& ids);
+    void fillCloud(const std_msgs::Header& header, const Keypoints3D& keypoints, const std::array<size_t, 4>& offsets,
+                   const std::array<int, 4>& partCounts, const std::vector<int>& ids);
+
+    SkeletonOptions mOptions;
+    ros::Publisher mMarkersPublisher, mCloudPublisher;
+
+    // the messages are reused across frames, so that the markers keep their memory
+    visualization_msgs::MarkerArray mMarkers;
+    sensor_msgs::PointCloud2 mCloud;
+
+    // whether the messages hold the persons of the last frame
+    bool mMarkersFilled = false, mCloudFilled = false;
+  };
+}
@@ -0,0 +1,52 @@
+/**
+* subscriberMonitor.hpp: header file for SubscriberMonitor. the monitor stops the camera reader
+*                        while none of the outputs of its camera has a subscriber and resumes it
+*                        as soon as someone subscribes again. it also holds the camera reader
+*                        back while openpose warms up
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// ROS headers
+#include <ros/ros.h>
+
+// ros_openpose headers
+#include <ros_openpose/cameraReader.hpp>
+
+// c++ headers
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ros_openpose
+{
+  // watches the publishers of a single camera. it is created with std::make_shared, as the
+  // status callbacks only hold a weak reference to it
+  class SubscriberMonitor : public std::enable_shared_from_this<SubscriberMonitor>
+  {
+  private:
+    const std::shared_ptr<CameraReader> mSPtrCameraReader;
+    const bool mEnabled;
+    bool mPaused = false;
+    std::vector<ros::Publisher> mPublishers;
+    std::mutex mMutex;
+
+  public:
+    // a disabled monitor never stops the camera reader
+    SubscriberMonitor(const std::shared_ptr<CameraReader>& sPtrCameraReader, const bool enabled);
+
+    // the callback to be passed to the advertise() call of each publisher, as both the connect and the
+    // disconnect callback. it is empty if the monitor is disabled
+    ros::SubscriberStatusCallback statusCallback();
+
+    // adds a publisher to watch. a publisher which is not advertised is ignored
+    void addPublisher(const ros::Publisher& publisher);
+
+    // stops the camera reader while paused or while none of the publishers has a subscriber, resumes it otherwise
+    void update();
+
+    // keeps the camera reader stopped regardless of the subscribers, e.g., until openpose is warmed up
+    void setPaused(const bool paused);
+  };
+}
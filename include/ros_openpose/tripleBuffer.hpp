@@ -0,0 +1,64 @@
+/**
+* tripleBuffer.hpp: header file for TripleBuffer. the triple buffer hands the latest value over
+*                   from a single producer thread to a single consumer thread without locking.
+*                   neither of them ever waits for the other
+* Date: 2026/10/14
+*/
+
+#pragma once
+
+// c++ headers
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace ros_openpose
+{
+  // a single-producer/single-consumer triple buffer. the producer owns the back buffer and the
+  // consumer owns the front buffer. the middle buffer is swapped atomically with either of them.
+  // the consumer therefore always gets the latest value and the older ones are dropped
+  template <typename T>
+  class TripleBuffer
+  {
+  private:
+    // the lower bits of the middle index hold the buffer, the flag tells whether it holds a value
+    // which the consumer has not seen yet
+    static const uint8_t INDEX_MASK = 3;
+    static const uint8_t FRESH_FLAG = 4;
+
+    std::array<T, 3> mBuffers;
+    std::atomic<uint8_t> mMiddle{1};
+    uint8_t mBack = 0;   // owned by the producer
+    uint8_t mFront = 2;  // owned by the consumer
+
+  public:
+    // producer: the buffer to be filled with the next value
+    T& back()
+    {
+      return mBuffers[mBack];
+    }
+
+    // producer: hands the back buffer over to the consumer. the acquire-release exchange makes
+    // the written value visible to the consumer and returns the buffer it released
+    void publish()
+    {
+      mBack = mMiddle.exchange(mBack | FRESH_FLAG, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // consumer: takes the latest value published by the producer. returns false if there is none,
+    // the front buffer keeps the value taken previously in this case
+    bool update()
+    {
+      if (!(mMiddle.load(std::memory_order_relaxed) & FRESH_FLAG))
+        return false;
+      mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & INDEX_MASK;
+      return true;
+    }
+
+    // consumer: the value taken by the last update. it stays valid until the next update
+    const T& front() const
+    {
+      return mBuffers[mFront];
+    }
+  };
+}
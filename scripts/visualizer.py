@@ -97,11 +97,10 @@ class RealtimeVisualization():
     def isValid(self, bodyPart):
         '''
         When should we consider a body part as a valid entity?
-        We make sure that the score and z coordinate is a positive number.
-        Notice that the z coordinate denotes the distance of the object located
-        in front of the camera. Therefore it must be a positive number always.
+        The node marks a body part as valid when it was detected and a valid
+        depth was found for it.
         '''
-        return bodyPart.score > 0 and bodyPart.point.z > 0
+        return bodyPart.valid
 
 
     def frame_callback(self, data):
@@ -114,8 +113,10 @@ class RealtimeVisualization():
 
         for person in data.persons:
             now = rospy.Time.now()
-            person_counter = 1 if person_counter >= len(self.colors) else person_counter
-            marker_color = self.colors[person_counter]
+
+            # a tracked person keeps its color and id. otherwise, use the index of the person
+            person_number = person.id if person.id >= 0 else person_counter
+            marker_color = self.colors[person_number % len(self.colors)]
 
             marker_counter += 1
             upper_body = self.create_marker(marker_counter, marker_color, Marker.LINE_STRIP, self.skeleton_line_width, now)
@@ -135,7 +136,7 @@ class RealtimeVisualization():
             legs.points = [person.bodyParts[idx].point for idx in self.legs_ids if self.isValid(person.bodyParts[idx])]
 
             # assign person id and 3D position
-            person_id.text = str(person_counter)
+            person_id.text = str(person_number)
             nose = person.bodyParts[self.nose_id]
             if self.isValid(nose):
                 person_id.pose.position = Point(nose.point.x, nose.point.y - 0.05, nose.point.z)
@@ -0,0 +1,298 @@
+/**
+* benchmarkCameraReader.cpp: benchmark of CameraReader. it measures the conversion of the images in the image
+*                            callback, the handoff of the frames to the consumer and the lifting of the keypoints
+*                            to 3D space. the images are synthetic unless a recorded color and depth image are
+*                            given. the results are written to stdout as csv
+* Date: 2026/10/14
+*/
+
+// ROS headers
+#include <ros/ros.h>
+#include <sensor_msgs/distortion_models.h>
+
+// ros_openpose headers
+#include <ros_openpose/cameraReader.hpp>
+
+// OpenCV headers
+#include <opencv2/highgui/highgui.hpp>
+
+// c++ headers
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  using namespace ros_openpose;
+
+  // the number of body keypoints of a person in the default body model, i.e., BODY_25
+  const int BODY_PARTS = 25;
+
+  // the fraction of the keypoints which were not detected by openpose, i.e., whose score is zero
+  const double MISSING_KEYPOINTS = 0.1;
+
+  // a recorded or synthetic frame
+  struct Fixture
+  {
+    std::string name;
+    cv::Mat colorImage;  // bgr8
+    cv::Mat depthImage;  // 16UC1, in millimeters
+  };
+
+  // a camera reader which subscribes to nothing. the frames are handed to it directly
+  struct Reader
+  {
+    ros::NodeHandle nh;
+    CameraReader reader;
+
+    Reader() : reader(nh, "", "", "")
+    {
+    }
+  };
+
+  // runs the operation repeatedly for at least 'minTime' seconds and returns the time per operation (in
+  // nanoseconds). the number of operations per timing grows, so that reading the clock costs nothing
+  template <typename Operation>
+  double measure(Operation operation, const double minTime, unsigned long long& iterations)
+  {
+    typedef std::chrono::steady_clock Clock;
+
+    // warm the caches up
+    operation();
+
+    iterations = 0;
+    unsigned long long batch = 1;
+    const auto start = Clock::now();
+    double elapsed = 0.0;
+    while (elapsed < minTime)
+    {
+      for (unsigned long long i = 0; i < batch; i++)
+        operation();
+      iterations += batch;
+      batch *= 2;
+      elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return 1e9 * elapsed / iterations;
+  }
+
+  // writes a row of the csv. 'items' is the number of items, e.g., keypoints, handled by one operation
+  void report(const std::string& benchmark, const Fixture& fixture, const std::string& variant, const int persons,
+              const unsigned long long iterations, const double nsPerOperation, const double items = 1.0)
+  {
+    std::printf("%s,%s,%d,%d,%s,%d,%llu,%.1f,%.0f\n", benchmark.c_str(), fixture.name.c_str(),
+                fixture.colorImage.cols, fixture.colorImage.rows, variant.c_str(), persons, iterations,
+                nsPerOperation, 1e9 * items / nsPerOperation);
+    std::fflush(stdout);
+  }
+
+  // a depth image of a tilted plane from 1 to 3 meters with noise. a few pixels have no valid depth,
+  // just like the shadows of a real depth camera
+  cv::Mat createDepthImage(const cv::Size& size, std::mt19937& random)
+  {
+    cv::Mat depthImage(size, CV_16UC1);
+    std::normal_distribution<float> noise(0.f, 5.f);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    for (auto v = 0; v < size.height; v++)
+    {
+      auto row = depthImage.ptr<uint16_t>(v);
+      for (auto u = 0; u < size.width; u++)
+      {
+        const auto depth = 1000.f + 2000.f * u / size.width + noise(random);
+        row[u] = uniform(random) < 0.05f ? 0 : static_cast<uint16_t>(depth);
+      }
+    }
+    return depthImage;
+  }
+
+  Fixture createFixture(const int width, const int height, std::mt19937& random)
+  {
+    Fixture fixture;
+    fixture.name = "synthetic";
+    fixture.colorImage = cv::Mat(height, width, CV_8UC3);
+    cv::randu(fixture.colorImage, cv::Scalar::all(0), cv::Scalar::all(255));
+    fixture.depthImage = createDepthImage(fixture.colorImage.size(), random);
+    return fixture;
+  }
+
+  // builds a message from the image. the message holds a copy of the image
+  sensor_msgs::ImageConstPtr toImageMsg(const cv::Mat& image, const std::string& encoding)
+  {
+    auto msg = boost::make_shared<sensor_msgs::Image>();
+    msg->header.stamp = ros::Time::now();
+    msg->width = image.cols;
+    msg->height = image.rows;
+    msg->encoding = encoding;
+    msg->step = static_cast<uint32_t>(image.cols * image.elemSize());
+    msg->data.resize(msg->step * image.rows);
+    for (auto v = 0; v < image.rows; v++)
+      std::memcpy(&msg->data[v * msg->step], image.ptr(v), msg->step);
+    return msg;
+  }
+
+  // the intrinsics of a camera with a horizontal field of view of about 65 degrees. the plumb bob model
+  // makes the reader build the lookup table of the undistorted rays
+  sensor_msgs::CameraInfoConstPtr createCameraInfo(const cv::Size& size, const bool distorted)
+  {
+    auto camInfo = boost::make_shared<sensor_msgs::CameraInfo>();
+    camInfo->width = size.width;
+    camInfo->height = size.height;
+    const auto focalLength = 0.8 * size.width;
+    camInfo->K = {{focalLength, 0.0, 0.5 * size.width, 0.0, focalLength, 0.5 * size.height, 0.0, 0.0, 1.0}};
+    camInfo->distortion_model = sensor_msgs::distortion_models::PLUMB_BOB;
+    camInfo->D = distorted ? std::vector<double>{0.1, -0.05, 0.001, 0.001, 0.0} : std::vector<double>(5, 0.0);
+    return camInfo;
+  }
+
+  // keypoints in openpose layout, i.e., (x, y, score), spread over the image
+  std::vector<float> createKeypoints(const cv::Size& size, const int count, std::mt19937& random)
+  {
+    std::uniform_real_distribution<float> x(0.f, size.width - 1.f), y(0.f, size.height - 1.f), uniform(0.f, 1.f);
+    std::vector<float> keypoints(3 * count);
+    for (auto i = 0; i < count; i++)
+    {
+      keypoints[3 * i] = x(random);
+      keypoints[3 * i + 1] = y(random);
+      keypoints[3 * i + 2] = uniform(random) < MISSING_KEYPOINTS ? 0.f : 0.5f + 0.5f * uniform(random);
+    }
+    return keypoints;
+  }
+
+  // the cost of the image callback, i.e., sharing or converting the color image and sharing the depth image
+  void benchmarkImageCallback(const Fixture& fixture, const double minTime)
+  {
+    const auto depthMsg = toImageMsg(fixture.depthImage, sensor_msgs::image_encodings::TYPE_16UC1);
+
+    // bgr8 is shared, rgb8 is converted unless the conversion is left to the consumer
+    const std::vector<std::pair<std::string, bool>> variants{{"bgr8", true}, {"rgb8", true}, {"rgb8", false}};
+    for (const auto& variant : variants)
+    {
+      Reader reader;
+      reader.reader.setColorConversion(variant.second);
+      const auto colorMsg = toImageMsg(fixture.colorImage, variant.first);
+
+      unsigned long long iterations;
+      const auto ns = measure([&] { reader.reader.addFrame(colorMsg, depthMsg); }, minTime, iterations);
+      report("image_callback", fixture, variant.first + (variant.second ? "" : "_raw"), 0, iterations, ns);
+    }
+  }
+
+  // the handoff of the frames from the image callback to a consumer on another thread. the producer runs as
+  // fast as it can, hence the consumer gets only a part of the frames
+  void benchmarkFrameHandoff(const Fixture& fixture, const double minTime)
+  {
+    Reader reader;
+    const auto colorMsg = toImageMsg(fixture.colorImage, sensor_msgs::image_encodings::BGR8);
+    const auto depthMsg = toImageMsg(fixture.depthImage, sensor_msgs::image_encodings::TYPE_16UC1);
+
+    std::atomic<bool> running{true};
+    unsigned long long framesTaken = 0;
+    std::thread consumer([&] {
+      cv_bridge::CvImageConstPtr colorImage, depthImage;
+      unsigned long long frameNumber = 0;
+      ros::Time callbackTime;
+      while (running)
+      {
+        if (reader.reader.waitForNewFrame(colorImage, depthImage, frameNumber, callbackTime,
+                                          std::chrono::milliseconds{10}))
+          framesTaken++;
+      }
+    });
+
+    unsigned long long iterations;
+    const auto start = std::chrono::steady_clock::now();
+    const auto ns = measure([&] { reader.reader.addFrame(colorMsg, depthMsg); }, minTime, iterations);
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    running = false;
+    consumer.join();
+
+    report("handoff_producer", fixture, "bgr8", 0, iterations, ns);
+    report("handoff_consumer", fixture, "bgr8", 0, framesTaken, framesTaken > 0 ? 1e9 * elapsed / framesTaken : 0.0);
+  }
+
+  // lifting the keypoints of several persons to 3D space, point by point and all at once
+  void benchmarkLifting(const Fixture& fixture, const double minTime, std::mt19937& random)
+  {
+    const std::vector<std::pair<std::string, DepthSampling>> samplings{{"nearest", DepthSampling::Nearest},
+                                                                        {"bilinear", DepthSampling::Bilinear},
+                                                                        {"median", DepthSampling::Median},
+                                                                        {"min", DepthSampling::MinValid}};
+    const std::vector<int> personCounts{1, 5, 20};
+    const auto size = fixture.colorImage.size();
+
+    for (const auto distorted : {false, true})
+    {
+      Reader reader;
+      reader.reader.setCameraInfo(createCameraInfo(size, distorted));
+      for (const auto& sampling : samplings)
+      {
+        reader.reader.setDepthSampling(sampling.second, 5);
+        const auto variant = sampling.first + (distorted ? "/plumb_bob" : "/none");
+        for (const auto persons : personCounts)
+        {
+          const auto count = persons * BODY_PARTS;
+          const auto keypoints = createKeypoints(size, count, random);
+
+          unsigned long long iterations;
+          float point[3];
+          auto ns = measure(
+              [&] {
+                for (auto i = 0; i < count; i++)
+                  reader.reader.compute3DPoint(fixture.depthImage, keypoints[3 * i], keypoints[3 * i + 1], point);
+              },
+              minTime, iterations);
+          report("compute_3d_point", fixture, variant, persons, iterations, ns, count);
+
+          Keypoints3D points;
+          points.resize(count);
+          ns = measure([&] { reader.reader.liftKeypoints(fixture.depthImage, keypoints.data(), count, points); },
+                       minTime, iterations);
+          report("lift_keypoints", fixture, variant, persons, iterations, ns, count);
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  ros::init(argc, argv, "benchmark_camera_reader");
+
+  // usage: benchmarkCameraReader [min_time] [color_image depth_image]
+  const auto minTime = argc > 1 ? std::atof(argv[1]) : 0.2;
+  std::mt19937 random(42);
+
+  std::vector<Fixture> fixtures;
+  for (const auto& size : std::vector<cv::Size>{{640, 480}, {1280, 720}, {1920, 1080}})
+    fixtures.push_back(createFixture(size.width, size.height, random));
+
+  // a recorded frame, e.g., saved from the color and the aligned depth topic of the camera
+  if (argc > 3)
+  {
+    Fixture fixture;
+    fixture.name = "recorded";
+    fixture.colorImage = cv::imread(argv[2], cv::IMREAD_COLOR);
+    fixture.depthImage = cv::imread(argv[3], cv::IMREAD_UNCHANGED);
+    if (fixture.colorImage.empty() || fixture.depthImage.type() != CV_16UC1 ||
+        fixture.depthImage.rows != fixture.colorImage.rows || fixture.depthImage.cols != fixture.colorImage.cols)
+    {
+      std::fprintf(stderr, "Expected a color image and a 16-bit depth image of the same size\n");
+      return -1;
+    }
+    fixtures.push_back(fixture);
+  }
+
+  std::printf("benchmark,fixture,width,height,variant,persons,iterations,ns_per_op,items_per_second\n");
+  for (const auto& fixture : fixtures)
+  {
+    benchmarkImageCallback(fixture, minTime);
+    benchmarkFrameHandoff(fixture, minTime);
+    benchmarkLifting(fixture, minTime, random);
+  }
+  return 0;
+}
@@ -9,33 +9,91 @@
 
 #include <ros_openpose/cameraReader.hpp>
 
+// ROS headers
+#include <sensor_msgs/distortion_models.h>
+
+// OpenCV headers
+#include <opencv2/calib3d/calib3d.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+// c++ headers
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// SIMD headers
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace ros_openpose
 {
-  CameraReader::CameraReader(ros::NodeHandle& nh, const std::string& colorTopic, const std::string& depthTopic,
-                             const std::string& camInfoTopic)
-    : mNh(nh), mColorTopic(colorTopic), mDepthTopic(depthTopic), mCamInfoTopic(camInfoTopic)
+  // the largest supported window for sampling the depth around a keypoint
+  const int MAX_DEPTH_WINDOW_SIZE = 15;
+
+  bool stringToDepthSampling(const std::string& name, DepthSampling& depthSampling)
   {
-    // std::cout << "[" << this << "] constructor called" << std::endl;
-    subscribe();
+    if (name == "nearest")
+      depthSampling = DepthSampling::Nearest;
+    else if (name == "bilinear")
+      depthSampling = DepthSampling::Bilinear;
+    else if (name == "median")
+      depthSampling = DepthSampling::Median;
+    else if (name == "min")
+      depthSampling = DepthSampling::MinValid;
+    else
+      return false;
+    return true;
   }
 
-  CameraReader::CameraReader(const CameraReader& other)
-    : mNh(other.mNh), mColorTopic(other.mColorTopic), mDepthTopic(other.mDepthTopic), mCamInfoTopic(other.mCamInfoTopic)
+  // deprojects the pixels (x, y) with the given depths z in place, i.e., x = (x - cx) / fx * z and
+  // y = (y - cy) / fy * z. it processes four points at a time if SIMD instructions are available
+  static void deprojectPixels(float* x, float* y, const float* z, const size_t count,
+                              const CameraIntrinsics& intrinsics)
   {
-    // std::cout << "[" << this << "] copy constructor called" << std::endl;
-    subscribe();
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const auto cx = _mm_set1_ps(intrinsics.cx), cy = _mm_set1_ps(intrinsics.cy);
+    const auto fxInv = _mm_set1_ps(intrinsics.fxInv), fyInv = _mm_set1_ps(intrinsics.fyInv);
+    for (; i + 4 <= count; i += 4)
+    {
+      const auto depth = _mm_loadu_ps(z + i);
+      _mm_storeu_ps(x + i, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x + i), cx), fxInv), depth));
+      _mm_storeu_ps(y + i, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(y + i), cy), fyInv), depth));
+    }
+#elif defined(__ARM_NEON)
+    const auto cx = vdupq_n_f32(intrinsics.cx), cy = vdupq_n_f32(intrinsics.cy);
+    const auto fxInv = vdupq_n_f32(intrinsics.fxInv), fyInv = vdupq_n_f32(intrinsics.fyInv);
+    for (; i + 4 <= count; i += 4)
+    {
+      const auto depth = vld1q_f32(z + i);
+      vst1q_f32(x + i, vmulq_f32(vmulq_f32(vsubq_f32(vld1q_f32(x + i), cx), fxInv), depth));
+      vst1q_f32(y + i, vmulq_f32(vmulq_f32(vsubq_f32(vld1q_f32(y + i), cy), fyInv), depth));
+    }
+#endif
+
+    // remaining points
+    for (; i < count; i++)
+    {
+      x[i] = (x[i] - intrinsics.cx) * intrinsics.fxInv * z[i];
+      y[i] = (y[i] - intrinsics.cy) * intrinsics.fyInv * z[i];
+    }
   }
 
-  CameraReader& CameraReader::operator=(const CameraReader& other)
+  CameraReader::CameraReader(ros::NodeHandle& nh, const std::string& colorTopic, const std::string& depthTopic,
+                             const std::string& camInfoTopic, const SyncOptions& syncOptions, const bool active)
+    : mNh(nh)
+    , mColorTopic(colorTopic)
+    , mDepthTopic(depthTopic)
+    , mCamInfoTopic(camInfoTopic)
+    , mActive(active)
+    , mSyncOptions(syncOptions)
   {
-    // std::cout << "[" << this << "] copy assignment called" << std::endl;
-    mNh = other.mNh;
-    mColorTopic = other.mColorTopic;
-    mDepthTopic = other.mDepthTopic;
-    mCamInfoTopic = other.mCamInfoTopic;
-
+    // std::cout << "[" << this << "] constructor called" << std::endl;
     subscribe();
-    return *this;
   }
 
   // CameraReader::~CameraReader()
@@ -43,31 +101,200 @@ namespace ros_openpose
   //  std::cout << "[" << this << "] destructor called" << std::endl;
   //}
 
-  // we define the subscriber here. we are using TimeSynchronizer filter to receive the synchronized data
+  // we define the subscriber here. we are using a synchronizer filter to receive the synchronized data.
+  // it pairs the images either by identical or by nearest timestamps
   inline void CameraReader::subscribe()
   {
-    mSPtrColorImageSub = std::make_shared<message_filters::Subscriber<sensor_msgs::Image>>(mNh, mColorTopic, 1);
-    mSPtrDepthImageSub = std::make_shared<message_filters::Subscriber<sensor_msgs::Image>>(mNh, mDepthTopic, 1);
+    const auto syncQueueSize = std::max(mSyncOptions.syncQueueSize, 1);
+
+    mSPtrImageTransport = std::make_shared<image_transport::ImageTransport>(mNh);
+    mSPtrColorImageSub = std::make_shared<image_transport::SubscriberFilter>();
+    mSPtrDepthImageSub = std::make_shared<image_transport::SubscriberFilter>();
+    if (mActive)
+      subscribeImages();
 
-    int queueSize = 4;
+    // count the messages reaching the subscribers
+    mSPtrColorImageSub->registerCallback(&CameraReader::colorCountCallback, this);
+    mSPtrDepthImageSub->registerCallback(&CameraReader::depthCountCallback, this);
 
     // clang-format off
-    mSPtrSyncSubscriber = std::make_shared<message_filters::TimeSynchronizer<sensor_msgs::Image, sensor_msgs::Image> >(
-        *mSPtrColorImageSub,
-        *mSPtrDepthImageSub,
-        queueSize);
+    if (mSyncOptions.approximate)
+    {
+      ApproximateSyncPolicy policy(syncQueueSize);
+      if (mSyncOptions.maxInterval > 0.0)
+        policy.setMaxIntervalDuration(ros::Duration(mSyncOptions.maxInterval));
+
+      mSPtrApproximateSyncSubscriber = std::make_shared<message_filters::Synchronizer<ApproximateSyncPolicy>>(
+          policy,
+          *mSPtrColorImageSub,
+          *mSPtrDepthImageSub);
+
+      // define which function should be called when the data is available
+      mSPtrApproximateSyncSubscriber->registerCallback(&CameraReader::imageCallback, this);
+    }
+    else
+    {
+      mSPtrExactSyncSubscriber = std::make_shared<message_filters::Synchronizer<ExactSyncPolicy>>(
+          ExactSyncPolicy(syncQueueSize),
+          *mSPtrColorImageSub,
+          *mSPtrDepthImageSub);
+
+      // define which function should be called when the data is available
+      mSPtrExactSyncSubscriber->registerCallback(&CameraReader::imageCallback, this);
+    }
     // clang-format on
 
-    // define which function should be called when the data is available
-    mSPtrSyncSubscriber->registerCallback(&CameraReader::imageCallback, this);
+    // create a subscriber to read the camera parameters from the ROS. without a topic, the parameters
+    // are given by setCameraInfo()
+    if (!mCamInfoTopic.empty())
+      mCamInfoSubscriber = mNh.subscribe(mCamInfoTopic, 1, &CameraReader::camInfoCallback, this);
+  }
 
-    // create a subscriber to read the camera parameters from the ROS
-    mCamInfoSubscriber = mNh.subscribe(mCamInfoTopic, 1, &CameraReader::camInfoCallback, this);
+  // subscribes to the color and depth images through the chosen transports. the compressed images are decoded by
+  // the image_transport plugins before they reach the synchronizer. without topics, the frames are given by addFrame()
+  void CameraReader::subscribeImages()
+  {
+    const auto imageQueueSize = std::max(mSyncOptions.imageQueueSize, 1);
+    if (!mColorTopic.empty())
+      mSPtrColorImageSub->subscribe(*mSPtrImageTransport, mColorTopic, imageQueueSize,
+                                    image_transport::TransportHints(mSyncOptions.colorTransport));
+    if (!mDepthTopic.empty())
+      mSPtrDepthImageSub->subscribe(*mSPtrImageTransport, mDepthTopic, imageQueueSize,
+                                    image_transport::TransportHints(mSyncOptions.depthTransport));
+  }
+
+  void CameraReader::setActive(const bool active)
+  {
+    std::lock_guard<std::mutex> lock(mActiveMutex);
+    if (active == mActive)
+      return;
+
+    if (active)
+    {
+      // the messages sent while we were away are not lost ones
+      {
+        std::lock_guard<std::mutex> statisticsLock(mSyncStatisticsMutex);
+        mHasColorSeq = mHasDepthSeq = false;
+      }
+      subscribeImages();
+    }
+    else
+    {
+      mSPtrColorImageSub->unsubscribe();
+      mSPtrDepthImageSub->unsubscribe();
+    }
+
+    mActive = active;
+    ROS_INFO("%s the images of '%s'", active ? "Resumed receiving" : "Stopped receiving", mColorTopic.c_str());
+  }
+
+  void CameraReader::addFrame(const sensor_msgs::ImageConstPtr& colorMsg, const sensor_msgs::ImageConstPtr& depthMsg)
+  {
+    colorCountCallback(colorMsg);
+    depthCountCallback(depthMsg);
+    imageCallback(colorMsg, depthMsg);
+  }
+
+  void CameraReader::setCameraInfo(const sensor_msgs::CameraInfoConstPtr& camInfoMsg)
+  {
+    camInfoCallback(camInfoMsg);
+  }
+
+  bool CameraReader::waitForFrameTaken(const std::chrono::milliseconds& timeout)
+  {
+    // the consumer signals the condition only once it sees the waiter, see waitForNewFrame()
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTakenWaiters++;
+    const auto taken =
+        mTakenCondition.wait_for(lock, timeout, [&] { return mTakenFrameNumber.load() >= mFrameNumber.load(); });
+    mTakenWaiters--;
+    return taken;
+  }
+
+  // counts the received messages and the gaps in their sequence numbers
+  static void countMessage(const std_msgs::Header& header, unsigned long long& received, unsigned long long& dropped,
+                           uint32_t& lastSeq, bool& hasSeq)
+  {
+    if (hasSeq && header.seq > lastSeq + 1)
+      dropped += header.seq - lastSeq - 1;
+    lastSeq = header.seq;
+    hasSeq = true;
+    received++;
+  }
+
+  void CameraReader::colorCountCallback(const sensor_msgs::ImageConstPtr& colorMsg)
+  {
+    std::lock_guard<std::mutex> lock(mSyncStatisticsMutex);
+    countMessage(colorMsg->header, mSyncStatistics.colorReceived, mSyncStatistics.colorDropped, mLastColorSeq,
+                 mHasColorSeq);
+  }
+
+  void CameraReader::depthCountCallback(const sensor_msgs::ImageConstPtr& depthMsg)
+  {
+    std::lock_guard<std::mutex> lock(mSyncStatisticsMutex);
+    countMessage(depthMsg->header, mSyncStatistics.depthReceived, mSyncStatistics.depthDropped, mLastDepthSeq,
+                 mHasDepthSeq);
+  }
+
+  // counts the synchronized pair and logs the messages lost or left unmatched since the last
+  // report. it is called for every pair, but reports at most once per 10 seconds
+  void CameraReader::countPair()
+  {
+    std::lock_guard<std::mutex> lock(mSyncStatisticsMutex);
+    mSyncStatistics.pairs++;
+
+    const auto now = ros::WallTime::now();
+    if ((now - mLastSyncReportTime).toSec() < 10.0)
+      return;
+
+    const auto& last = mReportedSyncStatistics;
+    const auto& current = mSyncStatistics;
+    const auto colorDropped = current.colorDropped - last.colorDropped;
+    const auto depthDropped = current.depthDropped - last.depthDropped;
+    const auto colorUnmatched = current.colorUnmatched() - last.colorUnmatched();
+    const auto depthUnmatched = current.depthUnmatched() - last.depthUnmatched();
+
+    if (colorDropped + depthDropped + colorUnmatched + depthUnmatched > 0)
+    {
+      ROS_WARN("Synchronizer: %llu pairs, color images dropped %llu unmatched %llu, depth images dropped %llu "
+               "unmatched %llu in the last %.0f seconds",
+               current.pairs - last.pairs, colorDropped, colorUnmatched, depthDropped, depthUnmatched,
+               (now - mLastSyncReportTime).toSec());
+    }
+
+    mReportedSyncStatistics = mSyncStatistics;
+    mLastSyncReportTime = now;
   }
 
   void CameraReader::camInfoCallback(const sensor_msgs::CameraInfoConstPtr& camMsg)
   {
+    // the subscriber may deliver another message before it is shut down. the intrinsics and the lookup
+    // table must not change while the keypoints are being lifted with them
+    if (mCameraInfoClaimed.exchange(true))
+      return;
+
     mSPtrCameraInfo = std::make_shared<sensor_msgs::CameraInfo>(*camMsg);
+
+    /*
+     * K.at(0) = intrinsic.fx
+     * K.at(4) = intrinsic.fy
+     * K.at(2) = intrinsic.ppx
+     * K.at(5) = intrinsic.ppy
+     */
+    mIntrinsics.fx = static_cast<float>(camMsg->K[0]);
+    mIntrinsics.fy = static_cast<float>(camMsg->K[4]);
+    mIntrinsics.cx = static_cast<float>(camMsg->K[2]);
+    mIntrinsics.cy = static_cast<float>(camMsg->K[5]);
+    mIntrinsics.fxInv = 1.f / mIntrinsics.fx;
+    mIntrinsics.fyInv = 1.f / mIntrinsics.fy;
+    mImageWidth = static_cast<int>(camMsg->width);
+    mImageHeight = static_cast<int>(camMsg->height);
+
+    // the lens distortion is handled by a lookup table, so it costs nothing per frame
+    buildRayTable(*camMsg);
+
+    mHasIntrinsics.store(true, std::memory_order_release);
+
     // since the calibration parameters are static so we don't need to keep running
     // the subscriber. that is why, we stop the subscriber once we receive
     // the parameters successfully
@@ -77,22 +304,139 @@ namespace ros_openpose
     }
   }
 
+  void CameraReader::buildRayTable(const sensor_msgs::CameraInfo& camInfo)
+  {
+    mRayTableX.clear();
+    mRayTableY.clear();
+    mRayTableWidth = mRayTableHeight = 0;
+
+    // no need of the lookup table if the image is not distorted
+    if (std::all_of(camInfo.D.begin(), camInfo.D.end(), [](const double d) { return d == 0.0; }))
+      return;
+
+    // both models are handled by opencv
+    if (camInfo.distortion_model != sensor_msgs::distortion_models::PLUMB_BOB &&
+        camInfo.distortion_model != sensor_msgs::distortion_models::RATIONAL_POLYNOMIAL)
+    {
+      ROS_WARN("Distortion model '%s' is not supported. Ignoring the lens distortion.",
+               camInfo.distortion_model.c_str());
+      return;
+    }
+
+    const int width = camInfo.width, height = camInfo.height;
+    const auto startTime = ros::WallTime::now();
+
+    // undistort every pixel of the image at once
+    cv::Mat pixels(width * height, 1, CV_32FC2);
+    auto pixelPtr = pixels.ptr<cv::Vec2f>();
+    for (auto v = 0; v < height; v++)
+    {
+      for (auto u = 0; u < width; u++, pixelPtr++)
+      {
+        (*pixelPtr)[0] = static_cast<float>(u);
+        (*pixelPtr)[1] = static_cast<float>(v);
+      }
+    }
+
+    const cv::Mat K(3, 3, CV_64F, const_cast<double*>(camInfo.K.data()));
+    const cv::Mat D(1, static_cast<int>(camInfo.D.size()), CV_64F, const_cast<double*>(camInfo.D.data()));
+
+    // without R and P, the result is in normalized image coordinates
+    cv::Mat rays;
+    cv::undistortPoints(pixels, rays, K, D);
+
+    mRayTableX.resize(width * height);
+    mRayTableY.resize(width * height);
+    const auto rayPtr = rays.ptr<cv::Vec2f>();
+    for (auto i = 0; i < width * height; i++)
+    {
+      mRayTableX[i] = rayPtr[i][0];
+      mRayTableY[i] = rayPtr[i][1];
+    }
+    mRayTableWidth = width;
+    mRayTableHeight = height;
+
+    ROS_INFO("Built the undistortion lookup table for %dx%d pixels in %.1f ms", width, height,
+             (ros::WallTime::now() - startTime).toSec() * 1000.0);
+  }
+
+  bool CameraReader::lookupRay(const float pixel_x, const float pixel_y, float& ray_x, float& ray_y) const
+  {
+    // the same pixel as the one the depth is read from, see sampleDepth()
+    const int u = static_cast<int>(pixel_x), v = static_cast<int>(pixel_y);
+    if (u < 0 || v < 0 || u >= mRayTableWidth || v >= mRayTableHeight)
+      return false;
+
+    const auto index = v * mRayTableWidth + u;
+    ray_x = mRayTableX[index];
+    ray_y = mRayTableY[index];
+    return true;
+  }
+
+  cv_bridge::CvImageConstPtr CameraReader::shareDepthImage(const sensor_msgs::ImageConstPtr& depthMsg)
+  {
+    // floating point depth images are in meters. cv_bridge would just truncate them
+    // while converting to 16UC1, so we scale them to millimeters ourselves
+    if (depthMsg->encoding == sensor_msgs::image_encodings::TYPE_32FC1)
+    {
+      auto floatPtr = cv_bridge::toCvShare(depthMsg);
+      auto depthPtr = boost::make_shared<cv_bridge::CvImage>();
+      depthPtr->header = floatPtr->header;
+      depthPtr->encoding = sensor_msgs::image_encodings::TYPE_16UC1;
+      floatPtr->image.convertTo(depthPtr->image, CV_16UC1, 1000.0);
+      return depthPtr;
+    }
+
+    // our depth image type is 16UC1 (in millimeters), which needs no conversion
+    return cv_bridge::toCvShare(depthMsg, sensor_msgs::image_encodings::TYPE_16UC1);
+  }
+
   void CameraReader::imageCallback(const sensor_msgs::ImageConstPtr& colorMsg,
                                    const sensor_msgs::ImageConstPtr& depthMsg)
   {
+    // the time at which the synchronized pair arrived. it is used for the latency report
+    const auto callbackTime = ros::Time::now();
+    countPair();
+
     try
     {
       // since we don't want to change the data, therefore we need not copy the image, we can just share it.
-      // auto colorPtr = cv_bridge::toCvShare(colorMsg, sensor_msgs::image_encodings::BGR8);
+      // cv_bridge makes a copy only if the encoding has to be converted, e.g., from RGB8 to BGR8
+      const auto& encoding = colorMsg->encoding;
+      namespace enc = sensor_msgs::image_encodings;
+      const auto keepEncoding = !mConvertColor && (encoding == enc::BGR8 || encoding == enc::RGB8 ||
+                                                   encoding == enc::BGRA8 || encoding == enc::RGBA8 ||
+                                                   encoding == enc::MONO8);
+      auto colorPtr = keepEncoding ? cv_bridge::toCvShare(colorMsg) : cv_bridge::toCvShare(colorMsg, enc::BGR8);
+      auto depthPtr = shareDepthImage(depthMsg);
 
-      auto colorPtr = cv_bridge::toCvCopy(colorMsg, sensor_msgs::image_encodings::BGR8);
-      auto depthPtr = cv_bridge::toCvCopy(depthMsg, sensor_msgs::image_encodings::TYPE_16UC1);
+      // fill the back buffer and hand it over to the consumer. the frame number is published afterwards,
+      // so that a consumer seeing the new number also finds the frame
+      auto& frame = mFrames.back();
+      frame.colorImage = colorPtr;
+      frame.depthImage = depthPtr;
+      frame.callbackTime = callbackTime;
+      frame.readyTime = ros::Time::now();
+      frame.number = ++mProducedFrames;
+      mFrames.publish();
+      mFrameNumber.store(mProducedFrames, std::memory_order_release);
 
-      // it is very important to lock the below assignment operation.
-      // remember that we are using these variables from another thread too.
-      std::lock_guard<std::mutex> lock(mMutex);
-      mColorImage = colorPtr->image;
-      mDepthImage = depthPtr->image;
+      // wake up the threads waiting for a new frame. passing through the mutex makes sure that a thread
+      // which just found no new frame is already waiting on the condition, i.e., it can not miss the wake up
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+      }
+      mFrameCondition.notify_all();
+
+      const auto frameSignal = std::atomic_load(&mSPtrFrameSignal);
+      if (frameSignal)
+      {
+        {
+          std::lock_guard<std::mutex> lock(frameSignal->mutex);
+          frameSignal->count++;
+        }
+        frameSignal->condition.notify_all();
+      }
     }
     catch (cv_bridge::Exception& e)
     {
@@ -100,4 +444,194 @@ namespace ros_openpose
       ROS_ERROR_THROTTLE(10, "cv_bridge exception: %s", e.what());
     }
   }
+
+  void CameraReader::setDepthSampling(const DepthSampling depthSampling, const int windowSize)
+  {
+    mDepthSampling = depthSampling;
+
+    // the window must be centered around the keypoint, hence its size must be odd
+    mDepthWindowSize = std::max(1, std::min(windowSize, MAX_DEPTH_WINDOW_SIZE)) | 1;
+  }
+
+  void CameraReader::depthScale(const cv::Mat& depthImage, float& scale_x, float& scale_y) const
+  {
+    // some drivers leave the size of the image out of the camera info. the depth image is expected to
+    // match the color image then
+    scale_x = mImageWidth > 0 ? static_cast<float>(depthImage.cols) / mImageWidth : 1.f;
+    scale_y = mImageHeight > 0 ? static_cast<float>(depthImage.rows) / mImageHeight : 1.f;
+  }
+
+  bool CameraReader::sampleDepth(const cv::Mat& depthImage, const float pixel_x, const float pixel_y,
+                                 float& depthSI) const
+  {
+    // our depth image type is 16UC1 which has unsigned short as an underlying type
+    // keypoints outside of the image have no depth. the negated comparison also rejects nan
+    if (!(pixel_x >= 0.f && pixel_y >= 0.f && pixel_x <= depthImage.cols - 1 && pixel_y <= depthImage.rows - 1))
+      return false;
+
+    // the depth represents the distance of an object placed infront of the camera
+    // therefore depth must be always a positive number. zero marks a missing depth
+    unsigned short depth = 0;
+
+    switch (mDepthSampling)
+    {
+      case DepthSampling::Bilinear:
+      {
+        // interpolate the four neighboring pixels. the missing depths are left out
+        // and the weights of the remaining ones are normalized
+        const int x0 = static_cast<int>(pixel_x), y0 = static_cast<int>(pixel_y);
+        const int x1 = std::min(x0 + 1, depthImage.cols - 1), y1 = std::min(y0 + 1, depthImage.rows - 1);
+        const float ax = pixel_x - x0, ay = pixel_y - y0;
+
+        const unsigned short samples[4] = {depthImage.at<unsigned short>(y0, x0), depthImage.at<unsigned short>(y0, x1),
+                                           depthImage.at<unsigned short>(y1, x0), depthImage.at<unsigned short>(y1, x1)};
+        const float weights[4] = {(1.f - ax) * (1.f - ay), ax * (1.f - ay), (1.f - ax) * ay, ax * ay};
+
+        float weightSum = 0.f, depthSum = 0.f;
+        for (auto i = 0; i < 4; i++)
+        {
+          if (samples[i] > 0)
+          {
+            weightSum += weights[i];
+            depthSum += weights[i] * samples[i];
+          }
+        }
+
+        if (weightSum <= 1e-6f)
+          return false;
+
+        depthSI = depthSum / weightSum * 0.001f;
+        return true;
+      }
+
+      case DepthSampling::Median:
+      case DepthSampling::MinValid:
+      {
+        // collect the valid depths inside the window around the keypoint
+        const int radius = mDepthWindowSize / 2;
+        const int cx = static_cast<int>(pixel_x), cy = static_cast<int>(pixel_y);
+        const int xBegin = std::max(cx - radius, 0), xEnd = std::min(cx + radius, depthImage.cols - 1);
+        const int yBegin = std::max(cy - radius, 0), yEnd = std::min(cy + radius, depthImage.rows - 1);
+
+        std::array<unsigned short, MAX_DEPTH_WINDOW_SIZE * MAX_DEPTH_WINDOW_SIZE> samples;
+        size_t sampleCount = 0;
+        for (auto y = yBegin; y <= yEnd; y++)
+        {
+          const auto row = depthImage.ptr<unsigned short>(y);
+          for (auto x = xBegin; x <= xEnd; x++)
+            if (row[x] > 0)
+              samples[sampleCount++] = row[x];
+        }
+
+        if (sampleCount == 0)
+          return false;
+
+        if (mDepthSampling == DepthSampling::MinValid)
+        {
+          depth = *std::min_element(samples.begin(), samples.begin() + sampleCount);
+        }
+        else
+        {
+          const auto median = samples.begin() + sampleCount / 2;
+          std::nth_element(samples.begin(), median, samples.begin() + sampleCount);
+          depth = *median;
+        }
+        break;
+      }
+
+      // the pixel containing the keypoint, i.e., the coordinates are truncated as they always were
+      case DepthSampling::Nearest:
+      default:
+        depth = depthImage.at<unsigned short>(static_cast<int>(pixel_y), static_cast<int>(pixel_x));
+        break;
+    }
+
+    if (depth <= 0)
+      return false;
+
+    // convert to meter (SI units)
+    depthSI = depth * 0.001f;
+    return true;
+  }
+
+  bool CameraReader::compute3DPoint(const cv::Mat& depthImage, const float pixel_x, const float pixel_y,
+                                    float (&point)[3]) const
+  {
+    point[0] = point[1] = point[2] = 0.f;
+
+    // no need to proceed further if the depth image or the calibration parameters are not received yet
+    if (depthImage.empty() || !mHasIntrinsics.load(std::memory_order_acquire))
+      return false;
+
+    // the pixel belongs to the color image, the depth image may be decimated
+    float scaleX, scaleY, depthSI;
+    depthScale(depthImage, scaleX, scaleY);
+    if (!sampleDepth(depthImage, pixel_x * scaleX, pixel_y * scaleY, depthSI))
+      return false;
+
+    float rayX, rayY;
+    if (mRayTableX.empty())
+    {
+      rayX = (pixel_x - mIntrinsics.cx) * mIntrinsics.fxInv;
+      rayY = (pixel_y - mIntrinsics.cy) * mIntrinsics.fyInv;
+    }
+    else if (!lookupRay(pixel_x, pixel_y, rayX, rayY))
+    {
+      return false;
+    }
+
+    point[0] = depthSI * rayX;
+    point[1] = depthSI * rayY;
+    point[2] = depthSI;
+    return true;
+  }
+
+  void CameraReader::liftKeypoints(const cv::Mat& depthImage, const float* keypoints, const size_t count,
+                                   Keypoints3D& points, const size_t offset) const
+  {
+    auto x = points.x.data() + offset;
+    auto y = points.y.data() + offset;
+    auto z = points.z.data() + offset;
+    auto score = points.score.data() + offset;
+    auto valid = points.valid.data() + offset;
+
+    // no need to proceed further if the depth image or the calibration parameters are not received yet
+    const bool canLift = !depthImage.empty() && mHasIntrinsics.load(std::memory_order_acquire);
+    const bool useRayTable = canLift && !mRayTableX.empty();
+
+    // the keypoints belong to the color image, the depth image may be decimated
+    float scaleX = 1.f, scaleY = 1.f;
+    if (canLift)
+      depthScale(depthImage, scaleX, scaleY);
+
+    // first pass: split the keypoints into arrays and read their depth. openpose sets the score
+    // of an undetected keypoint to zero, its location is meaningless. with lens distortion, the
+    // pixels are replaced by their undistorted rays from the lookup table
+    for (size_t i = 0; i < count; i++)
+    {
+      const auto keypoint = keypoints + 3 * i;
+      x[i] = keypoint[0];
+      y[i] = keypoint[1];
+      score[i] = keypoint[2];
+
+      valid[i] = canLift && score[i] > 0.f && sampleDepth(depthImage, x[i] * scaleX, y[i] * scaleY, z[i]);
+      if (valid[i] && useRayTable)
+        valid[i] = lookupRay(keypoint[0], keypoint[1], x[i], y[i]);
+      if (!valid[i])
+        z[i] = 0.f;
+    }
+
+    // second pass: deproject all the pixels at once. the invalid keypoints end up at zero
+    // since their depth is zero. the rays from the lookup table only need to be scaled by the depth
+    if (canLift)
+    {
+      static const CameraIntrinsics identity{1.f, 1.f, 0.f, 0.f, 1.f, 1.f};
+      deprojectPixels(x, y, z, count, useRayTable ? identity : mIntrinsics);
+    }
+    else
+    {
+      std::fill(x, x + count, 0.f);
+      std::fill(y, y + count, 0.f);
+    }
+  }
 }
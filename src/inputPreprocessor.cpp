@@ -0,0 +1,121 @@
+/**
+* inputPreprocessor.cpp: class file for InputPreprocessor. the image is scaled down before it is
+*                        converted, so that the conversion works on the smaller image
+* Date: 2026/10/14
+*/
+
+// ros_openpose headers
+#include <ros_openpose/inputPreprocessor.hpp>
+
+// ROS headers
+#include <sensor_msgs/image_encodings.h>
+
+// OpenCV headers
+#include <opencv2/imgproc/imgproc.hpp>
+#ifdef ROS_OPENPOSE_WITH_CUDA
+#include <opencv2/cudaimgproc.hpp>
+#include <opencv2/cudawarping.hpp>
+#endif
+
+// c++ headers
+#include <algorithm>
+#include <cmath>
+
+namespace ros_openpose
+{
+  // the code of the opencv conversion from the given encoding to bgr8. returns false if the
+  // image needs no conversion
+  static bool conversionCode(const std::string& encoding, int& code)
+  {
+    namespace enc = sensor_msgs::image_encodings;
+    if (encoding == enc::RGB8)
+      code = cv::COLOR_RGB2BGR;
+    else if (encoding == enc::BGRA8)
+      code = cv::COLOR_BGRA2BGR;
+    else if (encoding == enc::RGBA8)
+      code = cv::COLOR_RGBA2BGR;
+    else if (encoding == enc::MONO8)
+      code = cv::COLOR_GRAY2BGR;
+    else
+      return false;
+    return true;
+  }
+
+  InputPreprocessor::InputPreprocessor(const PreprocessOptions& options) : mOptions(options)
+  {
+  }
+
+  bool InputPreprocessor::gpuAvailable()
+  {
+#ifdef ROS_OPENPOSE_WITH_CUDA
+    return cv::cuda::getCudaEnabledDeviceCount() > 0;
+#else
+    return false;
+#endif
+  }
+
+  bool InputPreprocessor::supportsEncoding(const std::string& encoding)
+  {
+    int code;
+    return encoding == sensor_msgs::image_encodings::BGR8 || conversionCode(encoding, code);
+  }
+
+  cv::Mat InputPreprocessor::prepare(const cv::Mat& image, const std::string& encoding)
+  {
+    int code;
+    const auto convert = conversionCode(encoding, code);
+
+    // only scale down, openpose would scale the image up to the net resolution anyway
+    auto size = image.size();
+    if (mOptions.inputHeight > 0 && image.rows > mOptions.inputHeight)
+    {
+      const auto scale = static_cast<double>(mOptions.inputHeight) / image.rows;
+      size.width = std::max(static_cast<int>(std::lround(image.cols * scale)), 1);
+      size.height = mOptions.inputHeight;
+    }
+    const auto resize = size != image.size();
+
+    if (!convert && !resize)
+      return image;
+
+    // the prepared image is written to a new matrix each time, as openpose holds it until the
+    // frame is done, i.e., possibly while the next frames are being prepared
+    cv::Mat prepared;
+
+#ifdef ROS_OPENPOSE_WITH_CUDA
+    if (mOptions.gpu)
+    {
+      mGpuImage.upload(image, mStream);
+      auto* current = &mGpuImage;
+      if (resize)
+      {
+        cv::cuda::resize(*current, mGpuResized, size, 0, 0, cv::INTER_AREA, mStream);
+        current = &mGpuResized;
+      }
+      if (convert)
+      {
+        cv::cuda::cvtColor(*current, mGpuConverted, code, 0, mStream);
+        current = &mGpuConverted;
+      }
+
+      // the only copy to the host, openpose takes its input from the host memory
+      current->download(prepared, mStream);
+      mStream.waitForCompletion();
+      return prepared;
+    }
+#endif
+
+    // the image shares its memory with the ros message, hence it is never converted in place
+    if (!resize)
+      cv::cvtColor(image, prepared, code);
+    else if (!convert)
+      cv::resize(image, prepared, size, 0, 0, cv::INTER_AREA);
+    else
+    {
+      cv::Mat resized;
+      cv::resize(image, resized, size, 0, 0, cv::INTER_AREA);
+      cv::cvtColor(resized, prepared, code);
+    }
+    return prepared;
+  }
+}
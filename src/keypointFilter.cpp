@@ -0,0 +1,169 @@
+/**
+* keypointFilter.cpp: class file for KeypointFilter. it implements the one euro filter and a
+*                     kalman filter with a constant velocity model
+* Date: 2026/10/14
+*/
+
+// ros_openpose headers
+#include <ros_openpose/keypointFilter.hpp>
+
+// c++ headers
+#include <algorithm>
+#include <cmath>
+
+namespace ros_openpose
+{
+  // a keypoint which was not seen for longer than that (in seconds) starts over
+  const double MAX_FILTER_GAP = 0.5;
+
+  bool stringToFilterType(const std::string& name, FilterType& filterType)
+  {
+    if (name == "none")
+      filterType = FilterType::None;
+    else if (name == "one_euro")
+      filterType = FilterType::OneEuro;
+    else if (name == "kalman")
+      filterType = FilterType::Kalman;
+    else
+      return false;
+    return true;
+  }
+
+  KeypointFilter::KeypointFilter(const FilterOptions& options)
+    : mOptions(options), mSlotIds(std::max(options.capacity, 1), -1), mSlotTimes(mSlotIds.size(), 0.0)
+  {
+  }
+
+  size_t KeypointFilter::findSlot(const int id)
+  {
+    size_t oldest = 0;
+    for (size_t slot = 0; slot < mSlotIds.size(); slot++)
+    {
+      if (mSlotIds[slot] == id)
+        return slot;
+      if (mSlotIds[oldest] >= 0 && (mSlotIds[slot] < 0 || mSlotTimes[slot] < mSlotTimes[oldest]))
+        oldest = slot;
+    }
+
+    // take a free slot or the one of the person seen least recently
+    mSlotIds[oldest] = id;
+    const auto states = mStates.begin() + oldest * mPartsPerPerson;
+    std::for_each(states, states + mPartsPerPerson, [](KeypointState& state) { state.initialized = false; });
+    return oldest;
+  }
+
+  void KeypointFilter::oneEuro(KeypointState& state, const float (&value)[3], const float dt) const
+  {
+    // smoothing factor of a low-pass filter with the given cutoff frequency
+    const auto alpha = [dt](const double cutoff) {
+      const auto tau = 1.0 / (2.0 * M_PI * cutoff);
+      return static_cast<float>(1.0 / (1.0 + tau / dt));
+    };
+
+    const auto rateAlpha = alpha(mOptions.derivativeCutoff);
+    for (auto axis = 0; axis < 3; axis++)
+    {
+      const auto rate = (value[axis] - state.value[axis]) / dt;
+      state.rate[axis] += rateAlpha * (rate - state.rate[axis]);
+
+      const auto valueAlpha = alpha(mOptions.minCutoff + mOptions.beta * std::fabs(state.rate[axis]));
+      state.value[axis] += valueAlpha * (value[axis] - state.value[axis]);
+    }
+  }
+
+  void KeypointFilter::kalman(KeypointState& state, const float (&value)[3], const float dt) const
+  {
+    // white noise acceleration model
+    const auto q = static_cast<float>(mOptions.processNoise * mOptions.processNoise);
+    const auto r = static_cast<float>(mOptions.measurementNoise * mOptions.measurementNoise);
+    const auto dt2 = dt * dt;
+
+    for (auto axis = 0; axis < 3; axis++)
+    {
+      // predict
+      auto& p00 = state.p00[axis];
+      auto& p01 = state.p01[axis];
+      auto& p11 = state.p11[axis];
+      state.value[axis] += state.rate[axis] * dt;
+      p00 += dt * (2.f * p01 + dt * p11) + 0.25f * q * dt2 * dt2;
+      p01 += dt * p11 + 0.5f * q * dt2 * dt;
+      p11 += q * dt2;
+
+      // update
+      const auto s = p00 + r;
+      const auto k0 = p00 / s;
+      const auto k1 = p01 / s;
+      const auto innovation = value[axis] - state.value[axis];
+      state.value[axis] += k0 * innovation;
+      state.rate[axis] += k1 * innovation;
+      p11 -= k1 * p01;
+      p00 *= 1.f - k0;
+      p01 *= 1.f - k0;
+    }
+  }
+
+  void KeypointFilter::apply(Keypoints3D& keypoints, const std::array<size_t, 4>& offsets,
+                             const std::array<int, 4>& partCounts, const std::vector<int>& ids, const ros::Time& stamp)
+  {
+    if (mOptions.type == FilterType::None)
+      return;
+
+    // the states are only reallocated if the number of keypoints changes, e.g., the face got enabled
+    size_t partsPerPerson = 0;
+    for (const auto partCount : partCounts)
+      partsPerPerson += partCount;
+    if (partsPerPerson != mPartsPerPerson)
+    {
+      mPartsPerPerson = partsPerPerson;
+      mStates.assign(mSlotIds.size() * mPartsPerPerson, KeypointState());
+      std::fill(mSlotIds.begin(), mSlotIds.end(), -1);
+    }
+
+    // a keypoint starts with the uncertainty of a single measurement and an unknown velocity
+    const auto initialVariance = static_cast<float>(mOptions.measurementNoise * mOptions.measurementNoise);
+
+    const auto time = stamp.toSec();
+    for (size_t person = 0; person < ids.size(); person++)
+    {
+      if (ids[person] < 0)
+        continue;
+
+      const auto slot = findSlot(ids[person]);
+      mSlotTimes[slot] = time;
+      auto state = mStates.begin() + slot * mPartsPerPerson;
+
+      for (size_t k = 0; k < partCounts.size(); k++)
+      {
+        const auto first = offsets[k] + person * partCounts[k];
+        for (auto part = 0; part < partCounts[k]; part++, state++)
+        {
+          const auto i = first + part;
+          if (!keypoints.valid[i])
+            continue;
+
+          const float value[3] = {keypoints.x[i], keypoints.y[i], keypoints.z[i]};
+          const auto dt = static_cast<float>(time - state->time);
+          if (!state->initialized || dt <= 0.f || dt > MAX_FILTER_GAP)
+          {
+            // start over from the current position
+            std::copy(value, value + 3, state->value);
+            std::fill(state->rate, state->rate + 3, 0.f);
+            std::fill(state->p00, state->p00 + 3, initialVariance);
+            std::fill(state->p01, state->p01 + 3, 0.f);
+            std::fill(state->p11, state->p11 + 3, 1.f);
+            state->initialized = true;
+          }
+          else if (mOptions.type == FilterType::OneEuro)
+            oneEuro(*state, value, dt);
+          else
+            kalman(*state, value, dt);
+
+          state->time = time;
+          keypoints.x[i] = state->value[0];
+          keypoints.y[i] = state->value[1];
+          keypoints.z[i] = state->value[2];
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,58 @@
+/**
+* motionDetector.cpp: class file for MotionDetector. the motion is the fraction of the pixels of
+*                     the downsampled gray image whose value has changed
+* Date: 2026/10/14
+*/
+
+// ros_openpose headers
+#include <ros_openpose/motionDetector.hpp>
+
+// OpenCV headers
+#include <opencv2/imgproc/imgproc.hpp>
+
+// c++ headers
+#include <algorithm>
+
+namespace ros_openpose
+{
+  MotionDetector::MotionDetector(const MotionOptions& options) : mOptions(options)
+  {
+  }
+
+  bool MotionDetector::shouldProcess(const cv::Mat& colorImage)
+  {
+    if (!mOptions.enabled || colorImage.empty())
+      return true;
+
+    // the area interpolation averages the pixels, which also suppresses the noise of the camera
+    const auto width = std::max(std::min(mOptions.width, colorImage.cols), 1);
+    const auto height = std::max(colorImage.rows * width / colorImage.cols, 1);
+    cv::resize(colorImage, mSmall, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+    // the color image may still be in the encoding of the camera. swapping red and blue changes the
+    // gray level slightly, which does not matter for detecting a change
+    if (mSmall.channels() == 1)
+      mSmall.copyTo(mGray);
+    else
+      cv::cvtColor(mSmall, mGray, mSmall.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+
+    auto process = mReference.empty() || mReference.size() != mGray.size() ||
+                   mSkippedFrames >= mOptions.maxSkippedFrames;
+    if (!process)
+    {
+      cv::absdiff(mGray, mReference, mDifference);
+      cv::threshold(mDifference, mDifference, mOptions.pixelThreshold, 255, cv::THRESH_BINARY);
+      process = cv::countNonZero(mDifference) > mOptions.areaThreshold * mDifference.total();
+    }
+
+    if (!process)
+    {
+      mSkippedFrames++;
+      return false;
+    }
+
+    // compare the next frames with this one, so that a slow motion adds up
+    cv::swap(mReference, mGray);
+    mSkippedFrames = 0;
+    return true;
+  }
+}
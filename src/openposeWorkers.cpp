@@ -0,0 +1,767 @@
+/**
+* openposeWorkers.cpp: class file for the workers of the openpose wrapper. the input worker packs
+*                      the color images of all the cameras into one batch. the output worker lifts
+*                      the detected keypoints to 3D space and publishes them for each camera
+* Author: Ravi Joshi
+* Date: 2019/09/27
+* src: https://github.com/CMU-Perceptual-Computing-Lab/openpose/tree/master/examples/tutorial_api_cpp
+*/
+
+// ros_openpose headers
+#include <ros_openpose/openposeWorkers.hpp>
+
+// c++ headers
+#include <algorithm>
+
+namespace ros_openpose
+{
+  // the number of pending batches after which a missing batch is considered lost. it keeps
+  // the strict order from stalling the output forever if openpose failed on a batch
+  const size_t MAX_PENDING_BATCHES = 64;
+
+  // the number of frame messages of each camera created up front: the one being filled, the last one and
+  // the one the subscribers may still be reading
+  const size_t FRAME_POOL_SIZE = 3;
+
+  bool stringToOutputOrder(const std::string& name, OutputOrder& outputOrder)
+  {
+    if (name == "drop_late")
+      outputOrder = OutputOrder::DropLate;
+    else if (name == "strict")
+      outputOrder = OutputOrder::Strict;
+    else
+      return false;
+    return true;
+  }
+
+  bool stringToDropPolicy(const std::string& name, DropPolicy& dropPolicy)
+  {
+    if (name == "latest")
+      dropPolicy = DropPolicy::Latest;
+    else if (name == "queue")
+      dropPolicy = DropPolicy::Queue;
+    else
+      return false;
+    return true;
+  }
+
+  WUserInput::WUserInput(const std::vector<Camera>& cameras, const std::shared_ptr<PipelineState>& sPtrPipelineState)
+    : mCameras(cameras), mSPtrFrameSignal(std::make_shared<FrameSignal>()), mFrameNumbers(cameras.size(), 0),
+      mSPtrPipelineState(sPtrPipelineState), mWarmupRemaining(sPtrPipelineState->warmupFrames)
+  {
+    for (const auto& camera : mCameras)
+      camera.cameraReader->setFrameSignal(mSPtrFrameSignal);
+  }
+
+  sPtrDatum WUserInput::acquireDatum()
+  {
+    auto datumPtr = mDatumPool.acquire();
+    datumPtr->recycle();
+    return datumPtr;
+  }
+
+  sPtrVecSPtrDatum WUserInput::acquireBatch()
+  {
+    // an idle batch still holds the datums of its last frame. clearing it keeps its capacity
+    auto datumsPtr = mBatchPool.acquire();
+    datumsPtr->clear();
+    return datumsPtr;
+  }
+
+  void WUserInput::handOver(const sPtrVecSPtrDatum& datumsPtr)
+  {
+    const auto handoffTime = ros::Time::now();
+    for (auto& datumPtr : *datumsPtr)
+    {
+      datumPtr->batchNumber = mBatchNumber;
+      datumPtr->handoffTime = handoffTime;
+    }
+    mBatchNumber++;
+  }
+
+  sPtrVecSPtrDatum WUserInput::createWarmupBatch()
+  {
+    // a black image is as good as any other, the cost of the inference only depends on its size.
+    // the datums only read it, hence all of them share the same one
+    const cv::Mat image(mSPtrPipelineState->warmupSize, CV_8UC3, cv::Scalar::all(0));
+    auto datumsPtr = acquireBatch();
+    for (size_t camera = 0; camera < mCameras.size(); camera++)
+    {
+      auto datumPtr = acquireDatum();
+      datumPtr->warmup = true;
+      datumPtr->header.stamp = datumPtr->callbackTime = datumPtr->readyTime = datumPtr->producerTime = ros::Time::now();
+      datumPtr->subId = camera;
+      datumPtr->subIdMax = mCameras.size() - 1;
+      datumPtr->roi = cv::Rect(cv::Point(), image.size());
+      datumPtr->cvInputData = image;
+      datumsPtr->push_back(datumPtr);
+    }
+    return datumsPtr;
+  }
+
+  sPtrVecSPtrDatum WUserInput::workProducer()
+  {
+    try
+    {
+      // wait until a batch leaves openpose if the pipeline is full. the frames are taken from
+      // the cameras afterwards, so that openpose always gets the newest ones
+      auto& pipelineState = *mSPtrPipelineState;
+      if (pipelineState.dropPolicy == DropPolicy::Latest && pipelineState.depth > 0)
+      {
+        std::unique_lock<std::mutex> lock(pipelineState.mutex);
+        if (!pipelineState.condition.wait_for(lock, std::chrono::milliseconds{100}, [&] {
+              return pipelineState.batchesProduced - pipelineState.batchesConsumed < pipelineState.depth;
+            }))
+          return nullptr;
+      }
+
+      // the warmup batches go first. they take no sequence number, as they are never published
+      if (mWarmupRemaining > 0)
+      {
+        auto datumsPtr = createWarmupBatch();
+        handOver(datumsPtr);
+        mWarmupRemaining--;
+        std::lock_guard<std::mutex> lock(pipelineState.mutex);
+        pipelineState.batchesProduced++;
+        return datumsPtr;
+      }
+
+      // block until any of the cameras delivers a new frame. the timeout keeps this
+      // thread responsive when the wrapper is being stopped
+      {
+        std::unique_lock<std::mutex> lock(mSPtrFrameSignal->mutex);
+        if (!mSPtrFrameSignal->condition.wait_for(lock, std::chrono::milliseconds{100},
+                                                  [&] { return mSPtrFrameSignal->count != mSignalCount; }))
+        {
+          // the cameras may have been stopped since nobody listens to the results
+          const auto active = std::any_of(mCameras.begin(), mCameras.end(),
+                                          [](const Camera& camera) { return camera.cameraReader->isActive(); });
+
+          // display the warning at most once per 10 seconds
+          if (active)
+            ROS_WARN_THROTTLE(10, "No new color image frame received. Waiting...");
+          return nullptr;
+        }
+        mSignalCount = mSPtrFrameSignal->count;
+      }
+
+      // collect the new frame of each camera without blocking. the producer is only invoked
+      // when the wrapper has room for another batch, so the frames of the other cameras have
+      // usually arrived by then
+      auto datumsPtr = acquireBatch();
+      auto skippedDatumsPtr = acquireBatch();
+      unsigned long long framesDropped = 0;
+      for (size_t camera = 0; camera < mCameras.size(); camera++)
+      {
+        cv_bridge::CvImageConstPtr colorImage, depthImage;
+        ros::Time callbackTime, readyTime;
+        const auto previousFrameNumber = mFrameNumbers[camera];
+        if (!mCameras[camera].cameraReader->waitForNewFrame(colorImage, depthImage, mFrameNumbers[camera],
+                                                            callbackTime, readyTime, std::chrono::milliseconds{0}))
+          continue;
+
+        // the frames in between were replaced by newer ones before we could take them
+        if (previousFrameNumber > 0)
+          framesDropped += mFrameNumbers[camera] - previousFrameNumber - 1;
+
+        if (colorImage->image.empty())
+        {
+          // display the error at most once per 10 seconds
+          ROS_WARN_THROTTLE(10, "Empty color image frame detected. Ignoring...");
+          continue;
+        }
+
+        // take a datum from the pool
+        auto datumPtr = acquireDatum();
+        datumPtr->colorImagePtr = colorImage;
+        datumPtr->depthImagePtr = depthImage;
+        datumPtr->header = colorImage->header;
+        datumPtr->callbackTime = callbackTime;
+        datumPtr->readyTime = readyTime;
+        datumPtr->producerTime = ros::Time::now();
+        datumPtr->subId = camera;
+        datumPtr->subIdMax = mCameras.size() - 1;
+
+        // nothing has changed since the last frame processed by openpose. the frame
+        // bypasses openpose and the output worker publishes the last result again
+        if (!mCameras[camera].motionDetector->shouldProcess(colorImage->image))
+        {
+          datumPtr->skipped = true;
+          skippedDatumsPtr->push_back(datumPtr);
+          continue;
+        }
+
+        // fill the datum. only the region of interest is handed over to openpose. the cropped
+        // image shares its memory with the message unless the preprocessor converts or scales it
+        const auto preprocessingStart = ros::Time::now();
+        datumPtr->roi = mCameras[camera].regionOfInterest->next(colorImage->image.size());
+        datumPtr->cvInputData =
+            mCameras[camera].inputPreprocessor->prepare(colorImage->image(datumPtr->roi), colorImage->encoding);
+        datumPtr->preprocessing = ros::Time::now() - preprocessingStart;
+        datumsPtr->push_back(datumPtr);
+      }
+
+      std::lock_guard<std::mutex> lock(pipelineState.mutex);
+      pipelineState.framesDroppedAtInput += framesDropped;
+
+      // the skipped frames are handed over to the output worker directly, in a batch of their own
+      if (!skippedDatumsPtr->empty())
+      {
+        for (auto& datumPtr : *skippedDatumsPtr)
+          datumPtr->sequence = mSequence;
+        mSequence++;
+        pipelineState.skippedBatches.push_back(skippedDatumsPtr);
+        pipelineState.framesSkipped += skippedDatumsPtr->size();
+      }
+
+      // the frame which raised the signal might have been collected by the previous batch already
+      if (datumsPtr->empty())
+        return nullptr;
+
+      for (auto& datumPtr : *datumsPtr)
+        datumPtr->sequence = mSequence;
+      mSequence++;
+      handOver(datumsPtr);
+      pipelineState.batchesProduced++;
+      pipelineState.framesProcessed += datumsPtr->size();
+      return datumsPtr;
+    }
+    catch (const std::exception& e)
+    {
+      this->stop();
+      ROS_ERROR("Error %s at line number %d on function %s in file %s", e.what(), __LINE__, __FUNCTION__, __FILE__);
+      return nullptr;
+    }
+  }
+
+  WUserOutput::WUserOutput(const std::vector<Camera>& cameras, const OutputOptions& outputOptions,
+                           const std::shared_ptr<PipelineState>& sPtrPipelineState)
+    : mOutputOptions(outputOptions), mSPtrPipelineState(sPtrPipelineState)
+  {
+    // a few more than the limit, as several skipped batches may arrive before the reorder buffer is flushed
+    mPendingBatches.reserve(2 * MAX_PENDING_BATCHES);
+    mBatchEndTimes.resize(std::max(outputOptions.gpuCount, 1u));
+
+    const auto reservedPersons = static_cast<size_t>(std::max(outputOptions.numberPeopleMax, 0));
+    mOutputs.resize(cameras.size());
+    for (size_t camera = 0; camera < cameras.size(); camera++)
+    {
+      auto& output = mOutputs[camera];
+      output.camera = cameras[camera];
+      output.header.frame_id = cameras[camera].frameId;
+      output.framePool = ObjectPool<ros_openpose::FramePtr>(FRAME_POOL_SIZE);
+      output.packedFramePool = ObjectPool<ros_openpose::PackedFramePtr>(FRAME_POOL_SIZE);
+      output.sparePersons.reserve(FRAME_POOL_SIZE * reservedPersons);
+    }
+  }
+
+  void WUserOutput::workConsumer(const sPtrVecSPtrDatum& datumsPtr)
+  {
+    try
+    {
+      // openpose also invokes the consumer when no batch is ready. it gives the reorder
+      // buffer the chance to stop waiting for a missing batch
+      // the batches of the skipped frames did not pass through openpose
+      {
+        std::lock_guard<std::mutex> lock(mSPtrPipelineState->mutex);
+        mSkippedBatches.swap(mSPtrPipelineState->skippedBatches);
+      }
+      for (const auto& skippedBatch : mSkippedBatches)
+        addPendingBatch(skippedBatch);
+      mSkippedBatches.clear();
+
+      if (datumsPtr != nullptr && !datumsPtr->empty())
+      {
+        // make room for the next batch in the pipeline
+        {
+          std::lock_guard<std::mutex> lock(mSPtrPipelineState->mutex);
+          mSPtrPipelineState->batchesConsumed++;
+        }
+        mSPtrPipelineState->condition.notify_all();
+        stampInference(datumsPtr);
+
+        // openpose is warmed up once all of the warmup batches went through it
+        if (datumsPtr->front()->warmup)
+        {
+          if (mSPtrPipelineState->warmupCallback)
+            mSPtrPipelineState->warmupCallback(++mWarmupArrived);
+          releaseBatch(datumsPtr);
+        }
+        else
+          addPendingBatch(datumsPtr);
+      }
+
+      flushPendingBatches();
+      publishStatistics();
+    }
+    catch (const std::exception& e)
+    {
+      this->stop();
+      ROS_ERROR("Error %s at line number %d on function %s in file %s", e.what(), __LINE__, __FUNCTION__, __FILE__);
+    }
+  }
+
+  void WUserOutput::stampInference(const sPtrVecSPtrDatum& datumsPtr)
+  {
+    const auto outputTime = ros::Time::now();
+    const auto& front = *datumsPtr->front();
+
+    // the batch waited for the gpu which the batch 'gpuCount' before it held. the end of a batch older than
+    // the ones kept is approximated by the oldest one kept, the end of a batch yet to arrive by the handoff
+    const unsigned long long gpuCount = mBatchEndTimes.size();
+    auto inferenceStart = front.handoffTime;
+    if (front.batchNumber >= gpuCount && front.batchNumber - gpuCount < mBatchesArrived)
+    {
+      const auto oldestKept = mBatchesArrived - std::min(mBatchesArrived, gpuCount);
+      const auto previous = std::max(front.batchNumber - gpuCount, oldestKept);
+      inferenceStart = std::max(inferenceStart, mBatchEndTimes[previous % gpuCount]);
+    }
+    mBatchEndTimes[mBatchesArrived % gpuCount] = outputTime;
+    mBatchesArrived++;
+
+    const auto inference = outputTime - inferenceStart;
+    for (auto& datumPtr : *datumsPtr)
+    {
+      datumPtr->outputTime = outputTime;
+      datumPtr->inference = inference;
+    }
+
+    // the quality controller is given the time of openpose alone, the queues depend on the rate of the cameras
+    if (mSPtrPipelineState->qualityController && !front.warmup)
+      mSPtrPipelineState->qualityController->addSample(inference.toSec());
+  }
+
+  void WUserOutput::addPendingBatch(const sPtrVecSPtrDatum& datumsPtr)
+  {
+    const auto sequence = datumsPtr->front()->sequence;
+    if (sequence < mNextSequence)
+    {
+      // a newer batch was published already
+      mFramesDroppedAtOutput += datumsPtr->size();
+      ROS_WARN_THROTTLE(10, "Batch %llu arrived too late and was dropped (%llu frames so far).", sequence,
+                        mFramesDroppedAtOutput);
+      releaseBatch(datumsPtr);
+      return;
+    }
+
+    // the batch goes behind the last one with a lower sequence number, i.e., usually at the end
+    auto position = mPendingBatches.end();
+    while (position != mPendingBatches.begin() && (position - 1)->sequence > sequence)
+      position--;
+    mPendingBatches.insert(position, PendingBatch{sequence, datumsPtr, ros::WallTime::now()});
+  }
+
+  void WUserOutput::flushPendingBatches()
+  {
+    const auto now = ros::WallTime::now();
+    while (!mPendingBatches.empty())
+    {
+      const auto oldest = mPendingBatches.begin();
+
+      // the oldest pending batch has to wait for the batches in front of it
+      if (oldest->sequence != mNextSequence)
+      {
+        const auto timedOut = mOutputOptions.order == OutputOrder::DropLate &&
+                              (now - oldest->arrivalTime).toSec() >= mOutputOptions.reorderTimeout;
+        const auto overflowed = mPendingBatches.size() > MAX_PENDING_BATCHES;
+        if (!timedOut && !overflowed)
+          break;
+
+        // give up on the missing batches. they are dropped if they arrive later
+        if (overflowed)
+          ROS_WARN_THROTTLE(10, "Batches %llu to %llu are considered lost.", mNextSequence, oldest->sequence - 1);
+      }
+
+      publishBatch(oldest->datums);
+      releaseBatch(oldest->datums);
+      mNextSequence = oldest->sequence + 1;
+      mPendingBatches.erase(oldest);
+    }
+  }
+
+  void WUserOutput::publishStatistics()
+  {
+    const auto now = ros::WallTime::now();
+    const auto period = (now - mLastStatsTime).toSec();
+    if (period < 1.0)
+      return;
+    mLastStatsTime = now;
+
+    mPipelineStats.header.stamp = ros::Time::now();
+    mPipelineStats.framesReceived = 0;
+    mPipelineStats.imagesUnmatched = 0;
+    for (const auto& output : mOutputs)
+    {
+      const auto syncStatistics = output.camera.cameraReader->getSyncStatistics();
+      mPipelineStats.framesReceived += syncStatistics.pairs;
+      mPipelineStats.imagesUnmatched += syncStatistics.colorUnmatched() + syncStatistics.depthUnmatched();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mSPtrPipelineState->mutex);
+      mPipelineStats.framesDroppedAtInput = mSPtrPipelineState->framesDroppedAtInput;
+      mPipelineStats.framesProcessed = mSPtrPipelineState->framesProcessed;
+      mPipelineStats.framesSkipped = mSPtrPipelineState->framesSkipped;
+      mPipelineStats.batchesInFlight = mSPtrPipelineState->batchesProduced - mSPtrPipelineState->batchesConsumed;
+    }
+
+    mPipelineStats.framesDroppedAtOutput = mFramesDroppedAtOutput;
+    mPipelineStats.framesPublished = mFramesPublished;
+    mPipelineStats.pipelineDepth = mSPtrPipelineState->depth;
+    mPipelineStats.batchesPending = mPendingBatches.size();
+    if (mSPtrPipelineState->statsPublisher)
+      mSPtrPipelineState->statsPublisher.publish(mPipelineStats);
+
+    updateDiagnostics(period);
+  }
+
+  void WUserOutput::updateDiagnostics(const double period)
+  {
+    // the rates are taken over the period since the last report
+    const auto framesReceived = mPipelineStats.framesReceived - mLastFramesReceived;
+    const auto framesPublished = mPipelineStats.framesPublished - mLastFramesPublished;
+    mLastFramesReceived = mPipelineStats.framesReceived;
+    mLastFramesPublished = mPipelineStats.framesPublished;
+
+    if (!mSPtrPipelineState->diagnostics)
+      return;
+
+    // the name and the hardware id are set by the diagnostic updater
+    auto& status = mDiagnosticStatus;
+    status.clear();
+
+    const auto receivedFps = static_cast<int>(framesReceived / period + 0.5);
+    const auto publishedFps = static_cast<int>(framesPublished / period + 0.5);
+    status.add("received fps", receivedFps);
+    status.add("published fps", publishedFps);
+    status.add("frames dropped at input", mPipelineStats.framesDroppedAtInput);
+    status.add("frames dropped at output", mPipelineStats.framesDroppedAtOutput);
+    mProfiler.fillStatus(status);
+    PipelineProfiler::fillGpuMemory(status);
+
+    // the frames arrive, but none of them comes out of openpose
+    if (framesReceived > 0 && framesPublished == 0)
+      status.summary(diagnostic_msgs::DiagnosticStatus::WARN, "No frame published");
+    else
+      status.summary(diagnostic_msgs::DiagnosticStatus::OK, std::to_string(publishedFps) + " fps");
+
+    // the updater reads the status on the thread of the node
+    std::lock_guard<std::mutex> lock(mSPtrPipelineState->mutex);
+    mSPtrPipelineState->diagnosticStatus = status;
+  }
+
+  void WUserOutput::publishBatch(const sPtrVecSPtrDatum& datumsPtr)
+  {
+    // each datum of the batch belongs to the camera given by its 'subId'
+    for (const auto& datumPtr : *datumsPtr)
+    {
+      if (datumPtr->subId >= mOutputs.size())
+      {
+        ROS_WARN_THROTTLE(10, "Datum of unknown camera %llu detected. Ignoring...", datumPtr->subId);
+        continue;
+      }
+
+      auto& datum = *datumPtr;
+      auto& output = mOutputs[datum.subId];
+      if (datum.skipped)
+      {
+        republishDatum(datum, output);
+        mFramesPublished++;
+        continue;
+      }
+
+      // the keypoints were found in the region of interest, possibly scaled down by the preprocessor.
+      // they are mapped back to the full image, which in turn gives the region of interest of the next frames
+      const auto inputSize = datum.cvInputData.size();
+      RegionOfInterest::toFullImage(datum.poseKeypoints, datum.roi, inputSize);
+      RegionOfInterest::toFullImage(datum.faceKeypoints, datum.roi, inputSize);
+      RegionOfInterest::toFullImage(datum.handKeypoints[0], datum.roi, inputSize);
+      RegionOfInterest::toFullImage(datum.handKeypoints[1], datum.roi, inputSize);
+
+      output.camera.regionOfInterest->update(datum.poseKeypoints, datum.colorImagePtr->image.size());
+
+      publishDatum(datum, output);
+      mFramesPublished++;
+    }
+  }
+
+  void WUserOutput::publishDatum(const RosDatum& datum, CameraOutput& output)
+  {
+    const auto startTime = ros::Time::now();
+    const auto& cameraReader = output.camera.cameraReader;
+    const auto& publishers = output.camera.publishers;
+
+    // accesing each element of the keypoints
+    const auto& poseKeypoints = datum.poseKeypoints;
+
+    // the keypoints belong to the color image, so we use its timestamp. it lets
+    // the consumers line up the frame with depth images and tf
+    output.header.stamp = datum.header.stamp;
+
+    // get the size
+    const int personCount = poseKeypoints.getSize(0);
+
+    // the keypoints of the body, face and hands are lifted to 3D space all at once. they are
+    // placed one after another in the buffer. the face and hand keypoints are only available
+    // if openpose runs with '--face' and '--hand' flags
+    // src:
+    // https://github.com/CMU-Perceptual-Computing-Lab/openpose/blob/master/doc/output.md#keypoint-format-in-the-c-api
+    const std::array<const op::Array<float>*, 4> keypointArrays{
+        {&poseKeypoints, &datum.faceKeypoints, &datum.handKeypoints[0], &datum.handKeypoints[1]}};
+    std::array<size_t, 4> offsets;
+    size_t keypointCount = 0;
+    for (size_t i = 0; i < keypointArrays.size(); i++)
+    {
+      offsets[i] = keypointCount;
+      keypointCount += keypointArrays[i]->getVolume() / 3;
+    }
+
+    // we use the depth image synchronized with the color image for computing the points in 3D space. without
+    // one, all the keypoints are lifted as invalid
+    const auto depthImage = datum.depthImagePtr ? datum.depthImagePtr->image : cv::Mat();
+    mKeypoints3D.resize(keypointCount);
+    for (size_t i = 0; i < keypointArrays.size(); i++)
+    {
+      const auto count = keypointArrays[i]->getVolume() / 3;
+      if (count > 0)
+        cameraReader->liftKeypoints(depthImage, keypointArrays[i]->getConstPtr(), count, mKeypoints3D, offsets[i]);
+    }
+
+    // the persons are tracked with their body keypoints. the keypoints of the tracked persons are
+    // smoothed afterwards
+    std::array<int, 4> partCounts;
+    for (size_t i = 0; i < keypointArrays.size(); i++)
+      partCounts[i] = keypointArrays[i]->empty() ? 0 : keypointArrays[i]->getSize(1);
+    output.camera.personTracker->update(mKeypoints3D, offsets[0], personCount, partCounts[0], output.personIds);
+    output.camera.keypointFilter->apply(mKeypoints3D, offsets, partCounts, output.personIds, datum.header.stamp);
+
+    const auto liftingTime = ros::Time::now();
+
+    // update with the new data. the message is taken from the pool, since the previous ones may still be read
+    if (publishers.frame || publishers.frameSink)
+    {
+      const auto framePtr = output.framePool.acquire();
+      auto& frame = *framePtr;
+      frame.header = output.header;
+      if (mOutputOptions.numberPeopleMax > 0)
+        frame.persons.reserve(mOutputOptions.numberPeopleMax);
+      resizePersons(frame.persons, personCount, output.sparePersons);
+
+      for (auto person = 0; person < personCount; person++)
+      {
+        auto& personMsg = frame.persons[person];
+        personMsg.id = output.personIds[person];
+        fillBodyParts(personMsg.bodyParts, poseKeypoints, offsets[0], person);
+        fillBodyParts(personMsg.faceParts, *keypointArrays[1], offsets[1], person);
+        fillBodyParts(personMsg.leftHandParts, *keypointArrays[2], offsets[2], person);
+        fillBodyParts(personMsg.rightHandParts, *keypointArrays[3], offsets[3], person);
+      }
+      if (publishers.frame)
+        publishers.frame.publish(framePtr);
+      if (publishers.frameSink)
+        publishers.frameSink(frame);
+      output.frame = framePtr;
+    }
+    else
+      output.frame.reset();
+
+    // the packed frame is only built if someone listens to it
+    if (publishers.packedFrame.getNumSubscribers() > 0)
+    {
+      const auto packedFramePtr = output.packedFramePool.acquire();
+      packedFramePtr->header = output.header;
+      fillPackedFrame(*packedFramePtr, keypointArrays, offsets, personCount);
+      packedFramePtr->personIds.assign(output.personIds.begin(), output.personIds.end());
+      publishers.packedFrame.publish(packedFramePtr);
+      output.packedFrame = packedFramePtr;
+    }
+    else
+      output.packedFrame.reset();
+
+    output.camera.skeletonPublisher->publish(output.header, mKeypoints3D, offsets, partCounts, output.personIds);
+
+    const auto publishTime = ros::Time::now();
+
+    // per-frame timing report. the stages add up to the total. the queue holds the wait for the other cameras
+    // of the batch and for a free gpu
+    auto& latency = output.latency;
+    latency.header = output.header;
+    latency.cameraToCallback = datum.callbackTime - datum.header.stamp;
+    latency.callbackToProducer = datum.producerTime - datum.callbackTime;
+    latency.preprocessing = datum.preprocessing;
+    latency.queue = datum.outputTime - datum.inference - datum.producerTime - datum.preprocessing;
+    latency.inference = datum.inference;
+    latency.reorder = startTime - datum.outputTime;
+    latency.lifting = liftingTime - startTime;
+    latency.publish = publishTime - liftingTime;
+    latency.total = publishTime - datum.header.stamp;
+    if (publishers.latency)
+      publishers.latency.publish(latency);
+
+    mProfiler.addSample(Stage::Sync, latency.cameraToCallback.toSec());
+    mProfiler.addSample(Stage::Conversion, (datum.readyTime - datum.callbackTime).toSec());
+    mProfiler.addSample(Stage::ProducerWait, (datum.producerTime - datum.readyTime).toSec());
+    mProfiler.addSample(Stage::Preprocessing, latency.preprocessing.toSec());
+    mProfiler.addSample(Stage::Queue, latency.queue.toSec());
+    mProfiler.addSample(Stage::Inference, latency.inference.toSec());
+    mProfiler.addSample(Stage::Reorder, latency.reorder.toSec());
+    mProfiler.addSample(Stage::Lifting, latency.lifting.toSec());
+    mProfiler.addSample(Stage::Publish, latency.publish.toSec());
+    mProfiler.addSample(Stage::Total, latency.total.toSec());
+  }
+
+  void WUserOutput::republishDatum(const RosDatum& datum, CameraOutput& output)
+  {
+    const auto startTime = ros::Time::now();
+    const auto& publishers = output.camera.publishers;
+
+    // the persons of the last processed frame are still there. they are copied into a message of the pool,
+    // as the last message may still be read. copying keeps the memory of the parts of the persons
+    output.header.stamp = datum.header.stamp;
+    if (output.frame && (publishers.frame || publishers.frameSink))
+    {
+      const auto framePtr = output.framePool.acquire();
+      auto& frame = *framePtr;
+      frame.header = output.header;
+      resizePersons(frame.persons, output.frame->persons.size(), output.sparePersons);
+      std::copy(output.frame->persons.begin(), output.frame->persons.end(), frame.persons.begin());
+
+      if (publishers.frame)
+        publishers.frame.publish(framePtr);
+      if (publishers.frameSink)
+        publishers.frameSink(frame);
+      output.frame = framePtr;
+    }
+
+    // the packed frame is only up to date if it was filled for the last processed frame
+    if (output.packedFrame && publishers.packedFrame.getNumSubscribers() > 0)
+    {
+      const auto packedFramePtr = output.packedFramePool.acquire();
+      *packedFramePtr = *output.packedFrame;
+      packedFramePtr->header.stamp = datum.header.stamp;
+      publishers.packedFrame.publish(packedFramePtr);
+      output.packedFrame = packedFramePtr;
+    }
+    output.camera.skeletonPublisher->republish(datum.header.stamp);
+
+    const auto publishTime = ros::Time::now();
+
+    // there was neither inference nor lifting. the frame went to the reorder buffer right away
+    auto& latency = output.latency;
+    latency.header = output.header;
+    latency.cameraToCallback = datum.callbackTime - datum.header.stamp;
+    latency.callbackToProducer = datum.producerTime - datum.callbackTime;
+    latency.preprocessing = latency.queue = latency.inference = ros::Duration(0);
+    latency.reorder = startTime - datum.producerTime;
+    latency.lifting = ros::Duration(0);
+    latency.publish = publishTime - startTime;
+    latency.total = publishTime - datum.header.stamp;
+    if (publishers.latency)
+      publishers.latency.publish(latency);
+  }
+
+  void WUserOutput::releaseBatch(const sPtrVecSPtrDatum& datumsPtr)
+  {
+    // the vector itself is left alone, openpose may still hand the batch over to its gui
+    for (const auto& datumPtr : *datumsPtr)
+      datumPtr->releaseImages();
+  }
+
+  void WUserOutput::resizePersons(std::vector<ros_openpose::Person>& persons, const size_t count,
+                                  std::vector<ros_openpose::Person>& sparePersons)
+  {
+    while (persons.size() > count)
+    {
+      sparePersons.push_back(std::move(persons.back()));
+      persons.pop_back();
+    }
+    while (persons.size() < count && !sparePersons.empty())
+    {
+      persons.push_back(std::move(sparePersons.back()));
+      sparePersons.pop_back();
+    }
+    persons.resize(count);
+  }
+
+  void WUserOutput::fillBodyParts(std::vector<ros_openpose::BodyPart>& parts, const op::Array<float>& keypoints,
+                                  const size_t offset, const int person)
+  {
+    // the person has no such keypoints
+    if (person >= keypoints.getSize(0))
+    {
+      parts.clear();
+      return;
+    }
+
+    const int partCount = keypoints.getSize(1);
+    parts.resize(partCount);
+
+    for (auto bodyPart = 0; bodyPart < partCount; bodyPart++)
+    {
+      const auto index = person * partCount + bodyPart;
+      const auto lifted = offset + index;
+      auto& part = parts[bodyPart];
+
+      part.pixel.x = keypoints[3 * index];
+      part.pixel.y = keypoints[3 * index + 1];
+      part.score = mKeypoints3D.score[lifted];
+      part.point.x = mKeypoints3D.x[lifted];
+      part.point.y = mKeypoints3D.y[lifted];
+      part.point.z = mKeypoints3D.z[lifted];
+      part.valid = mKeypoints3D.valid[lifted];
+    }
+  }
+
+  void WUserOutput::fillPackedFrame(ros_openpose::PackedFrame& packedFrame,
+                                    const std::array<const op::Array<float>*, 4>& keypointArrays,
+                                    const std::array<size_t, 4>& offsets, const int personCount)
+  {
+    // the layout flag of each keypoint array
+    const std::array<uint8_t, 4> layouts{{ros_openpose::PackedFrame::LAYOUT_BODY, ros_openpose::PackedFrame::LAYOUT_FACE,
+                                          ros_openpose::PackedFrame::LAYOUT_HANDS,
+                                          ros_openpose::PackedFrame::LAYOUT_HANDS}};
+
+    std::array<int, 4> partCounts;
+    packedFrame.layout = 0;
+    packedFrame.partCount = 0;
+    for (size_t i = 0; i < keypointArrays.size(); i++)
+    {
+      partCounts[i] = keypointArrays[i]->empty() ? 0 : keypointArrays[i]->getSize(1);
+      if (partCounts[i] > 0)
+        packedFrame.layout |= layouts[i];
+      packedFrame.partCount += partCounts[i];
+    }
+
+    packedFrame.personCount = personCount;
+    packedFrame.bodyPartCount = partCounts[0];
+    packedFrame.facePartCount = partCounts[1];
+    packedFrame.handPartCount = partCounts[2];
+
+    const auto count = static_cast<size_t>(personCount) * packedFrame.partCount;
+    packedFrame.pixels.resize(2 * count);
+    packedFrame.points.resize(3 * count);
+    packedFrame.scores.resize(count);
+    packedFrame.valid.resize(count);
+
+    size_t packed = 0;
+    for (auto person = 0; person < personCount; person++)
+    {
+      for (size_t i = 0; i < keypointArrays.size(); i++)
+      {
+        for (auto bodyPart = 0; bodyPart < partCounts[i]; bodyPart++, packed++)
+        {
+          const auto index = person * partCounts[i] + bodyPart;
+          const auto lifted = offsets[i] + index;
+
+          packedFrame.pixels[2 * packed] = (*keypointArrays[i])[3 * index];
+          packedFrame.pixels[2 * packed + 1] = (*keypointArrays[i])[3 * index + 1];
+          packedFrame.points[3 * packed] = mKeypoints3D.x[lifted];
+          packedFrame.points[3 * packed + 1] = mKeypoints3D.y[lifted];
+          packedFrame.points[3 * packed + 2] = mKeypoints3D.z[lifted];
+          packedFrame.scores[packed] = mKeypoints3D.score[lifted];
+          packedFrame.valid[packed] = mKeypoints3D.valid[lifted];
+        }
+      }
+    }
+  }
+}
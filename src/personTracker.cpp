@@ -0,0 +1,189 @@
+/**
+* personTracker.cpp: class file for PersonTracker. the persons found in a frame are associated
+*                    with the tracks greedily, i.e., the closest pairs of person and track first
+* Date: 2026/10/14
+*/
+
+// ros_openpose headers
+#include <ros_openpose/personTracker.hpp>
+
+// c++ headers
+#include <algorithm>
+#include <cmath>
+
+namespace ros_openpose
+{
+  PersonTracker::PersonTracker(const TrackerOptions& options) : mOptions(options)
+  {
+  }
+
+  bool PersonTracker::computeCentroid(const Keypoints3D& keypoints, const size_t first, const int partCount,
+                                      std::array<float, 3>& centroid)
+  {
+    centroid.fill(0.f);
+    int count = 0;
+    for (auto i = first; i < first + partCount; i++)
+    {
+      if (!keypoints.valid[i])
+        continue;
+      centroid[0] += keypoints.x[i];
+      centroid[1] += keypoints.y[i];
+      centroid[2] += keypoints.z[i];
+      count++;
+    }
+
+    if (count == 0)
+      return false;
+
+    for (auto& value : centroid)
+      value /= count;
+    return true;
+  }
+
+  float PersonTracker::distance(const Track& track, const Keypoints3D& keypoints, const size_t first,
+                                const int partCount, const std::array<float, 3>& centroid)
+  {
+    float sum = 0.f;
+    int count = 0;
+    for (auto part = 0; part < partCount; part++)
+    {
+      const auto i = first + part;
+      if (!keypoints.valid[i] || !track.valid[part])
+        continue;
+      const auto dx = keypoints.x[i] - track.x[part];
+      const auto dy = keypoints.y[i] - track.y[part];
+      const auto dz = keypoints.z[i] - track.z[part];
+      sum += std::sqrt(dx * dx + dy * dy + dz * dz);
+      count++;
+    }
+
+    if (count > 0)
+      return sum / count;
+
+    const auto dx = centroid[0] - track.centroid[0];
+    const auto dy = centroid[1] - track.centroid[1];
+    const auto dz = centroid[2] - track.centroid[2];
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+  }
+
+  int64_t PersonTracker::cellKey(const int cellX, const int cellY, const int cellZ)
+  {
+    // 21 bits per axis are plenty for cells of a few decimeters
+    const int64_t mask = (1 << 21) - 1;
+    return ((cellX & mask) << 42) | ((cellY & mask) << 21) | (cellZ & mask);
+  }
+
+  std::array<int, 3> PersonTracker::cellOf(const std::array<float, 3>& point) const
+  {
+    std::array<int, 3> cell;
+    for (auto axis = 0; axis < 3; axis++)
+      cell[axis] = static_cast<int>(std::floor(point[axis] / mOptions.maxDistance));
+    return cell;
+  }
+
+  void PersonTracker::update(const Keypoints3D& keypoints, const size_t offset, const int personCount,
+                             const int partCount, std::vector<int>& ids)
+  {
+    ids.assign(personCount, -1);
+    if (!mOptions.enabled || mOptions.maxDistance <= 0.0)
+      return;
+
+    // the tracks were created with a different body model
+    if (!mTracks.empty() && static_cast<int>(mTracks.front().valid.size()) != partCount)
+      mTracks.clear();
+
+    // put the tracks into the grid. the cells are kept for reusing their memory, unless the
+    // persons walked around so much that most of them are empty
+    if (mGrid.size() > 8 * (mTracks.size() + 1))
+      mGrid.clear();
+    for (auto& cell : mGrid)
+      cell.second.clear();
+    for (size_t track = 0; track < mTracks.size(); track++)
+    {
+      const auto cell = cellOf(mTracks[track].centroid);
+      mGrid[cellKey(cell[0], cell[1], cell[2])].push_back(track);
+    }
+
+    // the candidates are the tracks in the neighboring cells of each person. a track whose centroid
+    // is within the distance threshold of the person always falls into one of these cells
+    mCandidates.clear();
+    mCentroids.resize(personCount);
+    mHasCentroid.assign(personCount, 0);
+    for (auto person = 0; person < personCount; person++)
+    {
+      const auto first = offset + person * partCount;
+      const auto& centroid = mCentroids[person];
+      mHasCentroid[person] = computeCentroid(keypoints, first, partCount, mCentroids[person]);
+      if (!mHasCentroid[person])
+        continue;
+
+      const auto cell = cellOf(centroid);
+      for (auto dx = -1; dx <= 1; dx++)
+        for (auto dy = -1; dy <= 1; dy++)
+          for (auto dz = -1; dz <= 1; dz++)
+          {
+            const auto found = mGrid.find(cellKey(cell[0] + dx, cell[1] + dy, cell[2] + dz));
+            if (found == mGrid.end())
+              continue;
+
+            for (const auto track : found->second)
+            {
+              const auto cost = distance(mTracks[track], keypoints, first, partCount, centroid);
+              if (cost <= mOptions.maxDistance)
+                mCandidates.push_back(Candidate{cost, person, track});
+            }
+          }
+    }
+
+    // associate the closest pairs first
+    std::sort(mCandidates.begin(), mCandidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.distance < b.distance; });
+
+    mTrackMatched.assign(mTracks.size(), 0);
+    mPersonTracks.assign(personCount, -1);
+    for (const auto& candidate : mCandidates)
+    {
+      if (mPersonTracks[candidate.person] >= 0 || mTrackMatched[candidate.track])
+        continue;
+      mPersonTracks[candidate.person] = candidate.track;
+      mTrackMatched[candidate.track] = 1;
+    }
+
+    // the tracks which were not seen are kept for a few frames, as the person might be occluded
+    for (size_t track = 0; track < mTracks.size(); track++)
+    {
+      if (!mTrackMatched[track])
+        mTracks[track].missedFrames++;
+    }
+
+    // update the matched tracks and start a new track for each of the remaining persons
+    for (auto person = 0; person < personCount; person++)
+    {
+      if (!mHasCentroid[person])
+        continue;
+
+      if (mPersonTracks[person] < 0)
+      {
+        mPersonTracks[person] = mTracks.size();
+        mTracks.emplace_back();
+        mTracks.back().id = mNextId++;
+      }
+
+      auto& track = mTracks[mPersonTracks[person]];
+      ids[person] = track.id;
+
+      const auto first = offset + person * partCount;
+      track.missedFrames = 0;
+      track.centroid = mCentroids[person];
+      track.x.assign(keypoints.x.begin() + first, keypoints.x.begin() + first + partCount);
+      track.y.assign(keypoints.y.begin() + first, keypoints.y.begin() + first + partCount);
+      track.z.assign(keypoints.z.begin() + first, keypoints.z.begin() + first + partCount);
+      track.valid.assign(keypoints.valid.begin() + first, keypoints.valid.begin() + first + partCount);
+    }
+
+    // remove the tracks which were not seen for too long
+    mTracks.erase(std::remove_if(mTracks.begin(), mTracks.end(),
+                                 [&](const Track& t) { return t.missedFrames > mOptions.maxMissedFrames; }),
+                  mTracks.end());
+  }
+}
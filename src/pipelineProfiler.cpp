@@ -0,0 +1,115 @@
+/**
+* pipelineProfiler.cpp: class file for PipelineProfiler
+* Date: 2026/10/14
+*/
+
+// ros_openpose headers
+#include <ros_openpose/pipelineProfiler.hpp>
+
+// OpenCV headers
+#ifdef ROS_OPENPOSE_WITH_CUDA
+#include <opencv2/core/cuda.hpp>
+#endif
+
+// c++ headers
+#include <algorithm>
+#include <cstdio>
+
+namespace ros_openpose
+{
+  // formats the value with the given number of decimals
+  static std::string toString(const double value, const int decimals)
+  {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    return buffer;
+  }
+
+  PipelineProfiler::PipelineProfiler(const size_t windowSize)
+  {
+    for (auto& window : mWindows)
+      window.samples.resize(std::max(windowSize, static_cast<size_t>(1)));
+    mSorted.reserve(mWindows.front().samples.size());
+  }
+
+  const char* PipelineProfiler::stageName(const size_t stage)
+  {
+    static const std::array<const char*, STAGE_COUNT> names{
+        {"sync", "conversion", "producer wait", "preprocessing", "queue", "inference", "reorder", "lifting", "publish",
+         "total"}};
+    return names[stage];
+  }
+
+  void PipelineProfiler::addSample(const Stage stage, const double duration)
+  {
+    auto& window = mWindows[static_cast<size_t>(stage)];
+    window.samples[window.count % window.samples.size()] = duration;
+    window.count++;
+  }
+
+  void PipelineProfiler::fillStatus(diagnostic_msgs::DiagnosticStatus& status)
+  {
+    const std::array<double, 3> percentiles{{50.0, 95.0, 99.0}};
+    for (size_t stage = 0; stage < STAGE_COUNT; stage++)
+    {
+      const auto& window = mWindows[stage];
+      const auto sampleCount = std::min(window.count, window.samples.size());
+      if (sampleCount == 0)
+        continue;
+
+      // nearest-rank percentiles. the later percentiles only need to look at the samples above the earlier ones
+      mSorted.assign(window.samples.begin(), window.samples.begin() + sampleCount);
+      auto first = mSorted.begin();
+      for (const auto percentile : percentiles)
+      {
+        const auto rank = std::min(static_cast<size_t>(percentile / 100.0 * sampleCount), sampleCount - 1);
+        const auto nth = mSorted.begin() + rank;
+        std::nth_element(first, nth, mSorted.end());
+        first = nth;
+
+        diagnostic_msgs::KeyValue value;
+        value.key = std::string(stageName(stage)) + " p" + toString(percentile, 0) + " (ms)";
+        value.value = toString(1e3 * *nth, 2);
+        status.values.push_back(value);
+      }
+    }
+  }
+
+  bool PipelineProfiler::fillGpuMemory(diagnostic_msgs::DiagnosticStatus& status)
+  {
+#ifdef ROS_OPENPOSE_WITH_CUDA
+    const auto deviceCount = cv::cuda::getCudaEnabledDeviceCount();
+    for (auto device = 0; device < deviceCount; device++)
+    {
+      const cv::cuda::DeviceInfo deviceInfo(device);
+      const auto totalMemory = deviceInfo.totalMemory();
+      const auto usedMemory = totalMemory - deviceInfo.freeMemory();
+
+      diagnostic_msgs::KeyValue value;
+      value.key = "gpu" + std::to_string(device) + " memory used (MB)";
+      value.value = toString(usedMemory / 1048576.0, 0) + " / " + toString(totalMemory / 1048576.0, 0);
+      status.values.push_back(value);
+    }
+    return deviceCount > 0;
+#else
+    return false;
+#endif
+  }
+
+  std::string PipelineProfiler::hardwareId()
+  {
+#ifdef ROS_OPENPOSE_WITH_CUDA
+    std::string hardwareId;
+    const auto deviceCount = cv::cuda::getCudaEnabledDeviceCount();
+    for (auto device = 0; device < deviceCount; device++)
+    {
+      if (!hardwareId.empty())
+        hardwareId += ", ";
+      hardwareId += "gpu" + std::to_string(device) + " " + cv::cuda::DeviceInfo(device).name();
+    }
+    if (!hardwareId.empty())
+      return hardwareId;
+#endif
+    return "openpose";
+  }
+}
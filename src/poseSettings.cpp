@@ -0,0 +1,65 @@
+/**
+* poseSettings.cpp: the quality presets of openpose
+* Date: 2026/10/14
+*/
+
+// ros_openpose headers
+#include <ros_openpose/poseSettings.hpp>
+
+// c++ headers
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace ros_openpose
+{
+  const std::vector<PoseSettings>& qualityPresets()
+  {
+    // the cost of the inference grows with the area of the network input and with the number of scales
+    static const std::vector<PoseSettings> presets{
+        {"-1x160", 1, 0.25, -1}, {"-1x256", 1, 0.25, -1}, {"-1x368", 1, 0.25, -1}, {"-1x480", 1, 0.25, -1},
+        {"-1x368", 4, 0.25, -1}};
+    return presets;
+  }
+
+  bool applyQualityPreset(const int quality, PoseSettings& settings)
+  {
+    const auto& presets = qualityPresets();
+    if (quality < 0 || quality >= static_cast<int>(presets.size()))
+      return false;
+
+    const auto& preset = presets[quality];
+    settings.netResolution = preset.netResolution;
+    settings.scaleNumber = preset.scaleNumber;
+    settings.scaleGap = preset.scaleGap;
+    return true;
+  }
+
+  double relativeCost(const PoseSettings& settings)
+  {
+    int width = -1, height = -1;
+    if (std::sscanf(settings.netResolution.c_str(), "%dx%d", &width, &height) != 2)
+      return 0.0;
+
+    if (width <= 0)
+      width = height;
+    if (height <= 0)
+      height = width;
+    return static_cast<double>(std::max(width, 1)) * std::max(height, 1) * std::max(settings.scaleNumber, 1);
+  }
+
+  int closestQualityPreset(const PoseSettings& settings)
+  {
+    // the costs are compared on a log scale, as the presets roughly double the cost from one to the next
+    const auto cost = std::log(std::max(relativeCost(settings), 1.0));
+    const auto& presets = qualityPresets();
+    auto closest = 0;
+    for (size_t quality = 1; quality < presets.size(); quality++)
+    {
+      if (std::fabs(std::log(relativeCost(presets[quality])) - cost) <
+          std::fabs(std::log(relativeCost(presets[closest])) - cost))
+        closest = quality;
+    }
+    return closest;
+  }
+}
@@ -0,0 +1,81 @@
+/**
+* qualityController.cpp: class file for QualityController. the decision is taken on the median
+*                        inference time, which ignores the occasional slow frame
+* Date: 2026/10/14
+*/
+
+// ros_openpose headers
+#include <ros_openpose/qualityController.hpp>
+
+// c++ headers
+#include <algorithm>
+
+namespace ros_openpose
+{
+  QualityController::QualityController(const AdaptiveOptions& options)
+    : mOptions(options), mSamples(std::max(options.windowSize, 1))
+  {
+  }
+
+  void QualityController::addSample(const double inferenceTime)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSamples[mSampleCount % mSamples.size()] = inferenceTime;
+    mSampleCount++;
+  }
+
+  bool QualityController::update(const PoseSettings& current, const double now, int& quality)
+  {
+    if (!mOptions.enabled)
+      return false;
+
+    auto budget = mOptions.targetFps > 0.0 ? 1.0 / mOptions.targetFps : 0.0;
+    if (mOptions.targetLatency > 0.0 && (budget <= 0.0 || mOptions.targetLatency < budget))
+      budget = mOptions.targetLatency;
+    if (budget <= 0.0 || now - mLastChangeTime < mOptions.holdTime)
+      return false;
+
+    // wait for a full window of frames, e.g., after a restart of openpose
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mSampleCount < mSamples.size())
+      return false;
+
+    mSorted = mSamples;
+    const auto middle = mSorted.begin() + mSorted.size() / 2;
+    std::nth_element(mSorted.begin(), middle, mSorted.end());
+    const auto median = *middle;
+
+    const auto& presets = qualityPresets();
+    const auto minQuality = std::max(mOptions.minQuality, 0);
+    const auto maxQuality = std::min(mOptions.maxQuality, static_cast<int>(presets.size()) - 1);
+    const auto currentQuality = std::min(std::max(closestQualityPreset(current), minQuality), maxQuality);
+
+    // custom settings in between the presets are kept as long as they fit the budget
+    auto target = -1;
+    const auto cost = relativeCost(current);
+    if (median > mOptions.downThreshold * budget)
+    {
+      // custom settings costlier than their closest preset fall back to it first
+      if (cost > relativeCost(presets[currentQuality]))
+        target = currentQuality;
+      else if (currentQuality > minQuality)
+        target = currentQuality - 1;
+    }
+    else if (currentQuality < maxQuality && cost > 0.0)
+    {
+      // the inference time is expected to grow with the cost of the network
+      const auto expected = median * relativeCost(presets[currentQuality + 1]) / cost;
+      if (expected < mOptions.upThreshold * budget)
+        target = currentQuality + 1;
+    }
+
+    if (target < 0)
+      return false;
+
+    // the frames processed with the old settings no longer count
+    mSampleCount = 0;
+    mLastChangeTime = now;
+    quality = target;
+    return true;
+  }
+}
@@ -0,0 +1,96 @@
+/**
+* regionOfInterest.cpp: class file for RegionOfInterest. the region of interest is the bounding
+*                       box of the persons detected in a frame, enlarged by a margin
+* Date: 2026/10/14
+*/
+
+// ros_openpose headers
+#include <ros_openpose/regionOfInterest.hpp>
+
+// c++ headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ros_openpose
+{
+  RegionOfInterest::RegionOfInterest(const RoiOptions& options) : mOptions(options)
+  {
+  }
+
+  cv::Rect RegionOfInterest::next(const cv::Size& imageSize)
+  {
+    const cv::Rect fullImage(cv::Point(0, 0), imageSize);
+    if (!mOptions.enabled)
+      return fullImage;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto roi = mRoi & fullImage;
+    if (roi.area() == 0 || mCroppedFrames >= mOptions.fullFrameInterval)
+    {
+      mCroppedFrames = 0;
+      return fullImage;
+    }
+
+    mCroppedFrames++;
+    return roi;
+  }
+
+  void RegionOfInterest::update(const op::Array<float>& poseKeypoints, const cv::Size& imageSize)
+  {
+    if (!mOptions.enabled)
+      return;
+
+    // the bounding box of the detected body keypoints of all the persons
+    auto minX = std::numeric_limits<float>::max(), minY = std::numeric_limits<float>::max();
+    auto maxX = std::numeric_limits<float>::lowest(), maxY = std::numeric_limits<float>::lowest();
+    const auto keypointCount = poseKeypoints.getVolume() / 3;
+    for (size_t i = 0; i < keypointCount; i++)
+    {
+      if (poseKeypoints[3 * i + 2] <= 0.f)
+        continue;
+      minX = std::min(minX, poseKeypoints[3 * i]);
+      maxX = std::max(maxX, poseKeypoints[3 * i]);
+      minY = std::min(minY, poseKeypoints[3 * i + 1]);
+      maxY = std::max(maxY, poseKeypoints[3 * i + 1]);
+    }
+
+    const int personCount = poseKeypoints.getSize(0);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // a person got lost. it might have left the region of interest, so we look at the full frame again
+    const auto personLost = personCount < mPersonCount;
+    mPersonCount = personCount;
+    if (minX > maxX || personLost)
+    {
+      mRoi = cv::Rect();
+      return;
+    }
+
+    // enlarge the bounding box by the margin, make sure it is not too small and keep it inside the image
+    const auto width = std::max(maxX - minX, 1.f), height = std::max(maxY - minY, 1.f);
+    const auto marginX = std::max(static_cast<float>(mOptions.margin * width), 0.5f * (mOptions.minSize - width));
+    const auto marginY = std::max(static_cast<float>(mOptions.margin * height), 0.5f * (mOptions.minSize - height));
+    const cv::Point topLeft(static_cast<int>(std::floor(minX - marginX)), static_cast<int>(std::floor(minY - marginY)));
+    const cv::Point bottomRight(static_cast<int>(std::ceil(maxX + marginX)), static_cast<int>(std::ceil(maxY + marginY)));
+    mRoi = cv::Rect(topLeft, bottomRight) & cv::Rect(cv::Point(0, 0), imageSize);
+  }
+
+  void RegionOfInterest::toFullImage(op::Array<float>& keypoints, const cv::Rect& roi, const cv::Size& inputSize)
+  {
+    const auto scaleX = inputSize.width > 0 ? static_cast<float>(roi.width) / inputSize.width : 1.f;
+    const auto scaleY = inputSize.height > 0 ? static_cast<float>(roi.height) / inputSize.height : 1.f;
+    if (roi.x == 0 && roi.y == 0 && scaleX == 1.f && scaleY == 1.f)
+      return;
+
+    const auto keypointCount = keypoints.getVolume() / 3;
+    for (size_t i = 0; i < keypointCount; i++)
+    {
+      if (keypoints[3 * i + 2] <= 0.f)
+        continue;
+      keypoints[3 * i] = keypoints[3 * i] * scaleX + roi.x;
+      keypoints[3 * i + 1] = keypoints[3 * i + 1] * scaleY + roi.y;
+    }
+  }
+}
@@ -1,412 +1,793 @@
 /**
-* rosOpenpose.cpp: the main file. it consists of two workers input and output worker.
-*                  the job of the input worker is to provide color images to openpose wrapper.
-*                  the job of the output worker is to receive the keypoints detected in 2D
-*                  space. it then converts 2D pixels to 3D coordinates (wrt camera coordinate
-*                  system)/
+* rosOpenpose.cpp: class file for RosOpenpose. it configures the openpose wrapper with two
+*                  workers, input and output worker. the job of the input worker is to provide
+*                  color images to openpose wrapper. the job of the output worker is to receive
+*                  the keypoints detected in 2D space. it then converts 2D pixels to 3D
+*                  coordinates (wrt camera coordinate system)
 * Author: Ravi Joshi
 * Date: 2019/09/27
 * src: https://github.com/CMU-Perceptual-Computing-Lab/openpose/tree/master/examples/tutorial_api_cpp
 */
 
-// ROS headers
-#include <ros/ros.h>
-
 // ros_openpose headers
 #include <ros_openpose/Frame.h>
-#include <ros_openpose/cameraReader.hpp>
+#include <ros_openpose/rosOpenpose.hpp>
 
 // OpenPose headers
+// the flags are defined in this translation unit only
 #include <openpose/flags.hpp>
 #include <openpose/headers.hpp>
 
-// define a few datatype
-typedef std::shared_ptr<op::Datum> sPtrDatum;
-typedef std::shared_ptr<std::vector<sPtrDatum>> sPtrVecSPtrDatum;
+// c++ headers
+#include <algorithm>
 
-// the input worker. the job of this worker is to provide color imagees to
-// openpose wrapper
-class WUserInput : public op::WorkerProducer<sPtrVecSPtrDatum>
+namespace ros_openpose
 {
-public:
-  WUserInput(const std::shared_ptr<ros_openpose::CameraReader>& sPtrCameraReader) : mSPtrCameraReader(sPtrCameraReader)
+  bool initOpenPoseFlags(const ros::NodeHandle& nh, const std::vector<std::string>& args)
   {
-  }
+    std::string openposeModelDir;
+    nh.getParam("openpose_model_dir", openposeModelDir);
 
-  void initializationOnThread()
-  {
+    if (openposeModelDir.empty())
+    {
+      ROS_FATAL("Missing 'openpose_model_dir' info in launch file");
+      return false;
+    }
+
+    // path of the dir where openpose models are located
+    FLAGS_model_folder = openposeModelDir;
+
+    // parsing command line flags. gflags expects a mutable argv
+    std::vector<char*> argv;
+    for (const auto& arg : args)
+      argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    int argc = static_cast<int>(args.size());
+    char** argvPtr = argv.data();
+    gflags::ParseCommandLineFlags(&argc, &argvPtr, true);
+    return true;
   }
 
-  sPtrVecSPtrDatum workProducer()
+  // clang-format off
+  void configureOpenPose(Wrapper& opWrapper,
+                         const std::vector<Camera>& cameras,
+                         const OutputOptions& outputOptions,
+                         const std::shared_ptr<PipelineState>& pipelineState)
+  // clang-format on
   {
     try
     {
-      // just to lower the CPU usage
-      // todo: need to think of a better way instead
-      std::this_thread::sleep_for(std::chrono::milliseconds{1});
-
-      // get the latest color image from the camera
-      auto& colorImage = mSPtrCameraReader->getColorFrame();
-
-      if (!colorImage.empty())
-      {
-        // create new datum
-        auto datumsPtr = std::make_shared<std::vector<sPtrDatum>>();
-        datumsPtr->emplace_back();
-        auto& datumPtr = datumsPtr->at(0);
-        datumPtr = std::make_shared<op::Datum>();
-
-        // fill the datum
-        datumPtr->cvInputData = colorImage;
-        return datumsPtr;
-      }
-      else
-      {
-        // display the error at most once per 10 seconds
-        ROS_WARN_THROTTLE(10, "Empty color image frame detected. Ignoring...");
-        return nullptr;
-      }
+      // Configuring OpenPose
+
+      // clang-format off
+      // logging_level
+      op::check(0 <= FLAGS_logging_level && FLAGS_logging_level <= 255,
+                "Wrong logging_level value.",
+                __LINE__,
+                __FUNCTION__,
+                __FILE__);
+
+      op::ConfigureLog::setPriorityThreshold((op::Priority)FLAGS_logging_level);
+      op::Profiler::setDefaultX(FLAGS_profile_speed);
+
+      // Applying user defined configuration - GFlags to program variables
+      // outputSize
+      const auto outputSize = op::flagsToPoint(FLAGS_output_resolution, "-1x-1");
+
+      // netInputSize
+      const auto netInputSize = op::flagsToPoint(FLAGS_net_resolution, "-1x368");
+
+      // faceNetInputSize
+      const auto faceNetInputSize = op::flagsToPoint(FLAGS_face_net_resolution, "368x368 (multiples of 16)");
+
+      // handNetInputSize
+      const auto handNetInputSize = op::flagsToPoint(FLAGS_hand_net_resolution, "368x368 (multiples of 16)");
+
+      // poseMode
+      const auto poseMode = op::flagsToPoseMode(FLAGS_body);
+
+      // poseModel
+      const auto poseModel = op::flagsToPoseModel(FLAGS_model_pose);
+
+      // JSON saving
+      if (!FLAGS_write_keypoint.empty())
+        ROS_INFO("Flag `write_keypoint` is deprecated and will eventually be removed. Please, use `write_json` instead.");
+
+      // keypointScaleMode
+      const auto keypointScaleMode = op::flagsToScaleMode(FLAGS_keypoint_scale);
+
+      // heatmaps to add
+      const auto heatMapTypes = op::flagsToHeatMaps(FLAGS_heatmaps_add_parts,
+                                                    FLAGS_heatmaps_add_bkg,
+                                                    FLAGS_heatmaps_add_PAFs);
+
+      const auto heatMapScaleMode = op::flagsToHeatMapScaleMode(FLAGS_heatmaps_scale);
+
+      // >1 camera view? the cameras are processed independently of each other, i.e., there
+      // is no 3D reconstruction from several views
+      // const auto multipleView = (FLAGS_3d || FLAGS_3d_views > 1 || FLAGS_flir_camera);
+      const auto multipleView = false;
+
+      // Face and hand detectors
+      const auto faceDetector = op::flagsToDetector(FLAGS_face_detector);
+      const auto handDetector = op::flagsToDetector(FLAGS_hand_detector);
+
+      // Enabling Google Logging
+      const bool enableGoogleLogging = true;
+
+      // Initializing the user custom classes
+      auto wUserInput = std::make_shared<WUserInput>(cameras, pipelineState);
+      // the messages of the output worker reserve room for as many persons as openpose may find
+      auto workerOutputOptions = outputOptions;
+      workerOutputOptions.numberPeopleMax = FLAGS_number_people_max;
+
+      // openpose works on as many batches at a time as it has gpus, which tells apart its time from its queues
+      const auto gpuCount = FLAGS_num_gpu > 0 ? FLAGS_num_gpu : op::getGpuNumber() - FLAGS_num_gpu_start;
+      workerOutputOptions.gpuCount = static_cast<unsigned int>(std::max(gpuCount, 1));
+      auto wUserOutput = std::make_shared<WUserOutput>(cameras, workerOutputOptions, pipelineState);
+
+      // Add custom processing
+      const auto workerInputOnNewThread = true;
+      opWrapper.setWorker(op::WorkerType::Input, wUserInput, workerInputOnNewThread);
+
+      const auto workerOutputOnNewThread = true;
+      opWrapper.setWorker(op::WorkerType::Output, wUserOutput, workerOutputOnNewThread);
+
+      // Pose configuration (use WrapperStructPose{} for default and recommended configuration)
+      const op::WrapperStructPose wrapperStructPose{poseMode,
+                                                    netInputSize,
+                                                    outputSize,
+                                                    keypointScaleMode,
+                                                    FLAGS_num_gpu,
+                                                    FLAGS_num_gpu_start,
+                                                    FLAGS_scale_number,
+                                                    (float)FLAGS_scale_gap,
+                                                    op::flagsToRenderMode(FLAGS_render_pose,
+                                                                          multipleView),
+                                                    poseModel,
+                                                    !FLAGS_disable_blending,
+                                                    (float)FLAGS_alpha_pose,
+                                                    (float)FLAGS_alpha_heatmap,
+                                                    FLAGS_part_to_show,
+                                                    FLAGS_model_folder,
+                                                    heatMapTypes,
+                                                    heatMapScaleMode,
+                                                    FLAGS_part_candidates,
+                                                    (float)FLAGS_render_threshold,
+                                                    FLAGS_number_people_max,
+                                                    FLAGS_maximize_positives,
+                                                    FLAGS_fps_max,
+                                                    FLAGS_prototxt_path,
+                                                    FLAGS_caffemodel_path,
+                                                    (float)FLAGS_upsampling_ratio,
+                                                    enableGoogleLogging};
+      opWrapper.configure(wrapperStructPose);
+
+      // Face configuration (use op::WrapperStructFace{} to disable it)
+      const op::WrapperStructFace wrapperStructFace{FLAGS_face,
+                                                    faceDetector,
+                                                    faceNetInputSize,
+                                                    op::flagsToRenderMode(FLAGS_face_render,
+                                                                          multipleView,
+                                                                          FLAGS_render_pose),
+                                                    (float)FLAGS_face_alpha_pose,
+                                                    (float)FLAGS_face_alpha_heatmap,
+                                                    (float)FLAGS_face_render_threshold};
+      opWrapper.configure(wrapperStructFace);
+
+      // Hand configuration (use op::WrapperStructHand{} to disable it)
+      const op::WrapperStructHand wrapperStructHand{FLAGS_hand,
+                                                    handDetector,
+                                                    handNetInputSize,
+                                                    FLAGS_hand_scale_number,
+                                                    (float)FLAGS_hand_scale_range,
+                                                    op::flagsToRenderMode(FLAGS_hand_render,
+                                                                          multipleView,
+                                                                          FLAGS_render_pose),
+                                                    (float)FLAGS_hand_alpha_pose,
+                                                    (float)FLAGS_hand_alpha_heatmap,
+                                                    (float)FLAGS_hand_render_threshold};
+      opWrapper.configure(wrapperStructHand);
+
+      // Extra functionality configuration (use op::WrapperStructExtra{} to disable it)
+      const op::WrapperStructExtra wrapperStructExtra{FLAGS_3d,
+                                                      FLAGS_3d_min_views,
+                                                      FLAGS_identification,
+                                                      FLAGS_tracking,
+                                                      FLAGS_ik_threads};
+      opWrapper.configure(wrapperStructExtra);
+
+      // Output (comment or use default argument to disable any output)
+      const op::WrapperStructOutput wrapperStructOutput{FLAGS_cli_verbose,
+                                                        FLAGS_write_keypoint,
+                                                        op::stringToDataFormat(FLAGS_write_keypoint_format),
+                                                        FLAGS_write_json,
+                                                        FLAGS_write_coco_json,
+                                                        FLAGS_write_coco_json_variants,
+                                                        FLAGS_write_coco_json_variant,
+                                                        FLAGS_write_images,
+                                                        FLAGS_write_images_format,
+                                                        FLAGS_write_video,
+                                                        FLAGS_write_video_fps,
+                                                        FLAGS_write_video_with_audio,
+                                                        FLAGS_write_heatmaps,
+                                                        FLAGS_write_heatmaps_format,
+                                                        FLAGS_write_video_3d,
+                                                        FLAGS_write_video_adam,
+                                                        FLAGS_write_bvh,
+                                                        FLAGS_udp_host,
+                                                        FLAGS_udp_port};
+      opWrapper.configure(wrapperStructOutput);
+
+      // GUI (comment or use default argument to disable any visual output)
+      const op::WrapperStructGui wrapperStructGui{op::flagsToDisplayMode(FLAGS_display,
+                                                                         FLAGS_3d),
+                                                  !FLAGS_no_gui_verbose,
+                                                  FLAGS_fullscreen};
+      opWrapper.configure(wrapperStructGui);
+      // clang-format on
+
+      // the queues between the threads of openpose hold at most as many batches as the pipeline
+      if (pipelineState->depth > 0)
+        opWrapper.setDefaultMaxSizeQueues(pipelineState->depth);
+
+      // Set to single-thread (for sequential processing and/or debugging and/or reducing latency)
+      if (FLAGS_disable_multi_thread)
+        opWrapper.disableMultiThreading();
     }
     catch (const std::exception& e)
     {
-      this->stop();
       ROS_ERROR("Error %s at line number %d on function %s in file %s", e.what(), __LINE__, __FUNCTION__, __FILE__);
-      return nullptr;
     }
   }
 
-private:
-  const std::shared_ptr<ros_openpose::CameraReader> mSPtrCameraReader;
-};
+  OutputOptions readOutputOptions(const ros::NodeHandle& nh)
+  {
+    OutputOptions outputOptions;
 
-// the outpout worker. the job of the output worker is to receive the keypoints
-// detected in 2D space. it then converts 2D pixels to 3D coordinates (wrt
-// camera coordinate system).
-class WUserOutput : public op::WorkerConsumer<sPtrVecSPtrDatum>
-{
-public:
-  // clang-format off
-  WUserOutput(const ros::Publisher& framePublisher,
-              const std::shared_ptr<ros_openpose::CameraReader>& sPtrCameraReader,
-              const std::string& frameId)
-    : mFramePublisher(framePublisher), mSPtrCameraReader(sPtrCameraReader)
+    // the order in which the frames are published if several gpus run in parallel
+    std::string outputOrder;
+    nh.param<std::string>("output_order", outputOrder, "drop_late");
+    nh.param("reorder_timeout", outputOptions.reorderTimeout, outputOptions.reorderTimeout);
+
+    if (!stringToOutputOrder(outputOrder, outputOptions.order))
+    {
+      ROS_WARN("Unknown output order '%s'. Using 'drop_late' instead.", outputOrder.c_str());
+      outputOptions.order = OutputOrder::DropLate;
+    }
+
+    // the persons keep their id across the frames as long as they are tracked
+    nh.param("tracking_enabled", outputOptions.tracker.enabled, outputOptions.tracker.enabled);
+    nh.param("tracking_max_distance", outputOptions.tracker.maxDistance, outputOptions.tracker.maxDistance);
+    nh.param("tracking_max_missed_frames", outputOptions.tracker.maxMissedFrames, outputOptions.tracker.maxMissedFrames);
+
+    // the keypoints of the tracked persons may be smoothed over time
+    auto& filterOptions = outputOptions.filter;
+    std::string filterType;
+    nh.param<std::string>("filter_type", filterType, "none");
+    nh.param("filter_capacity", filterOptions.capacity, filterOptions.capacity);
+    nh.param("filter_min_cutoff", filterOptions.minCutoff, filterOptions.minCutoff);
+    nh.param("filter_beta", filterOptions.beta, filterOptions.beta);
+    nh.param("filter_derivative_cutoff", filterOptions.derivativeCutoff, filterOptions.derivativeCutoff);
+    nh.param("filter_process_noise", filterOptions.processNoise, filterOptions.processNoise);
+    nh.param("filter_measurement_noise", filterOptions.measurementNoise, filterOptions.measurementNoise);
+
+    if (!stringToFilterType(filterType, filterOptions.type))
+    {
+      ROS_WARN("Unknown filter type '%s'. Using 'none' instead.", filterType.c_str());
+      filterOptions.type = FilterType::None;
+    }
+
+    return outputOptions;
+  }
+
+  void readDepthSampling(const ros::NodeHandle& nh, DepthSampling& depthSampling, int& windowSize)
   {
-    mFrame.header.frame_id = frameId;
+    std::string depthSamplingName;
+    nh.param<std::string>("depth_sampling", depthSamplingName, "nearest");
+    nh.param("depth_window_size", windowSize, windowSize);
+
+    if (!stringToDepthSampling(depthSamplingName, depthSampling))
+    {
+      ROS_WARN("Unknown depth sampling method '%s'. Using 'nearest' instead.", depthSamplingName.c_str());
+      depthSampling = DepthSampling::Nearest;
+    }
   }
-  // clang-format on
 
-  void initializationOnThread()
+  // the options which are common to all the cameras
+  struct CameraOptions
+  {
+    SyncOptions sync;
+    RoiOptions roi;
+    MotionOptions motion;
+    PreprocessOptions preprocess;
+    SkeletonOptions skeleton;
+    DepthSampling depthSampling = DepthSampling::Nearest;
+    int depthWindowSize = 5;
+
+    // stop receiving the images while none of the outputs of the camera has a subscriber
+    bool lazy = false;
+
+    // do not subscribe to the images until the monitor is resumed, e.g., once openpose is warmed up
+    bool paused = false;
+  };
+
+  // creates a camera from the parameters found under the given node handle
+  static Camera createCamera(ros::NodeHandle& nh, const CameraOptions& options)
   {
+    // define the parameters, we are going to read
+    std::string colorTopic, depthTopic, camInfoTopic, pubTopic, packedPubTopic, markersTopic, cloudTopic;
+    Camera camera;
+
+    // read the parameters from relative nodel handle
+    nh.getParam("color_topic", colorTopic);
+    nh.getParam("depth_topic", depthTopic);
+    nh.getParam("cam_info_topic", camInfoTopic);
+    nh.getParam("frame_id", camera.frameId);
+    nh.getParam("pub_topic", pubTopic);
+    nh.getParam("packed_pub_topic", packedPubTopic);
+    nh.getParam("markers_topic", markersTopic);
+    nh.getParam("cloud_topic", cloudTopic);
+
+    // the images are subscribed to by the monitor below, once the publishers are known
+    const auto active = false;
+    camera.cameraReader =
+        std::make_shared<CameraReader>(nh, colorTopic, depthTopic, camInfoTopic, options.sync, active);
+    camera.cameraReader->setDepthSampling(options.depthSampling, options.depthWindowSize);
+    camera.regionOfInterest = std::make_shared<RegionOfInterest>(options.roi);
+    camera.motionDetector = std::make_shared<MotionDetector>(options.motion);
+    camera.inputPreprocessor = std::make_shared<InputPreprocessor>(options.preprocess);
+
+    // the color images are converted on the gpu, cv_bridge hands them over as they are
+    camera.cameraReader->setColorConversion(!options.preprocess.gpu);
+
+    // the monitor is told whenever a subscriber of the outputs below connects or disconnects
+    camera.subscriberMonitor = std::make_shared<SubscriberMonitor>(camera.cameraReader, options.lazy);
+    const auto statusCallback = camera.subscriberMonitor->statusCallback();
+
+    // the frame consists of the location of detected body parts of each person.
+    // an empty topic disables it, e.g., if only the packed frame is needed
+    if (!pubTopic.empty())
+      camera.publishers.frame = nh.advertise<ros_openpose::Frame>(pubTopic, 1, statusCallback, statusCallback);
+
+    // the same data as the frame, but stored in flat arrays
+    if (!packedPubTopic.empty())
+      camera.publishers.packedFrame =
+          nh.advertise<ros_openpose::PackedFrame>(packedPubTopic, 1, statusCallback, statusCallback);
+
+    // per-frame timing of the pipeline, from the camera stamp until the frame gets published
+    camera.publishers.latency = nh.advertise<ros_openpose::Latency>("latency", 1);
+
+    // the skeletons for rviz and the keypoints as a point cloud. they are only built if someone listens
+    camera.skeletonPublisher =
+        std::make_shared<SkeletonPublisher>(nh, markersTopic, cloudTopic, options.skeleton, statusCallback);
+
+    // the latency is a diagnostic output, it does not keep the camera running
+    camera.subscriberMonitor->addPublisher(camera.publishers.frame);
+    camera.subscriberMonitor->addPublisher(camera.publishers.packedFrame);
+    camera.subscriberMonitor->addPublisher(camera.skeletonPublisher->getMarkersPublisher());
+    camera.subscriberMonitor->addPublisher(camera.skeletonPublisher->getCloudPublisher());
+
+    // nobody listens yet, unless the subscribers connected while the topics were being advertised
+    if (options.paused)
+      camera.subscriberMonitor->setPaused(true);
+    else
+      camera.subscriberMonitor->update();
+    return camera;
   }
 
-  void workConsumer(const sPtrVecSPtrDatum& datumsPtr)
+  RosOpenpose::RosOpenpose(ros::NodeHandle& nh) : mConstructionTime(ros::WallTime::now())
   {
-    try
+    // the options which are common to all the cameras
+    CameraOptions cameraOptions;
+
+    // the options of the synchronizer pairing the color and depth images
+    auto& syncOptions = cameraOptions.sync;
+    std::string syncPolicy;
+    nh.param<std::string>("sync_policy", syncPolicy, "exact");
+    nh.param("sync_max_interval", syncOptions.maxInterval, syncOptions.maxInterval);
+    nh.param("image_queue_size", syncOptions.imageQueueSize, syncOptions.imageQueueSize);
+    nh.param("sync_queue_size", syncOptions.syncQueueSize, syncOptions.syncQueueSize);
+
+    // the transports of the images, e.g., compressed for the color and compressedDepth for the depth images
+    nh.param("color_transport", syncOptions.colorTransport, syncOptions.colorTransport);
+    nh.param("depth_transport", syncOptions.depthTransport, syncOptions.depthTransport);
+
+    syncOptions.approximate = syncPolicy == "approximate";
+    if (!syncOptions.approximate && syncPolicy != "exact")
+      ROS_WARN("Unknown sync policy '%s'. Using 'exact' instead.", syncPolicy.c_str());
+
+    // the method used for reading the depth of a keypoint
+    readDepthSampling(nh, cameraOptions.depthSampling, cameraOptions.depthWindowSize);
+
+    // the order of the frames, the tracker and the filter
+    const auto outputOptions = readOutputOptions(nh);
+
+    // openpose may process only the part of the image around the persons found in the previous frames
+    auto& roiOptions = cameraOptions.roi;
+    nh.param("roi_enabled", roiOptions.enabled, roiOptions.enabled);
+    nh.param("roi_full_frame_interval", roiOptions.fullFrameInterval, roiOptions.fullFrameInterval);
+    nh.param("roi_margin", roiOptions.margin, roiOptions.margin);
+    nh.param("roi_min_size", roiOptions.minSize, roiOptions.minSize);
+
+    // the inference is skipped while nothing changes in front of the camera
+    auto& motionOptions = cameraOptions.motion;
+    nh.param("motion_enabled", motionOptions.enabled, motionOptions.enabled);
+    nh.param("motion_pixel_threshold", motionOptions.pixelThreshold, motionOptions.pixelThreshold);
+    nh.param("motion_area_threshold", motionOptions.areaThreshold, motionOptions.areaThreshold);
+    nh.param("motion_max_skipped_frames", motionOptions.maxSkippedFrames, motionOptions.maxSkippedFrames);
+
+    // the color images may be converted and scaled down before openpose, on the gpu if possible
+    auto& preprocessOptions = cameraOptions.preprocess;
+    nh.param("gpu_preprocessing", preprocessOptions.gpu, preprocessOptions.gpu);
+    nh.param("input_height", preprocessOptions.inputHeight, preprocessOptions.inputHeight);
+
+    if (preprocessOptions.gpu && !InputPreprocessor::gpuAvailable())
     {
-      if (datumsPtr != nullptr && !datumsPtr->empty())
-      {
-        // accesing each element of the keypoints
-        const auto& poseKeypoints = datumsPtr->at(0)->poseKeypoints;
-
-        // update timestamp
-        mFrame.header.stamp = ros::Time::now();
+      ROS_WARN("GPU preprocessing needs ros_openpose built with WITH_CUDA_PREPROCESSING and a CUDA device. "
+               "Using the CPU instead.");
+      preprocessOptions.gpu = false;
+    }
 
-        // make sure to clear previous data
-        mFrame.persons.clear();
+    // the inference may pause while nobody listens to the results
+    nh.param("lazy_processing", cameraOptions.lazy, cameraOptions.lazy);
 
-        // we use the latest depth image for computing point in 3D space
-        mSPtrCameraReader->copyLatestDepthImage();
+    // the skeleton markers for rviz
+    nh.param("skeleton_line_width", cameraOptions.skeleton.lineWidth, cameraOptions.skeleton.lineWidth);
+    nh.param("id_text_size", cameraOptions.skeleton.textSize, cameraOptions.skeleton.textSize);
 
-        // get the size
-        const int personCount = poseKeypoints.getSize(0);
-        const int bodyPartCount = poseKeypoints.getSize(1);
+    // the number of batches inside openpose and what happens to the frames if it can not keep up
+    auto pipelineState = std::make_shared<PipelineState>();
+    std::string dropPolicy;
+    int pipelineDepth;
+    nh.param<std::string>("drop_policy", dropPolicy, "latest");
+    nh.param("pipeline_depth", pipelineDepth, 2);
+    pipelineState->depth = std::max(pipelineDepth, 0);
 
-        mFrame.persons.resize(personCount);
+    if (!stringToDropPolicy(dropPolicy, pipelineState->dropPolicy))
+    {
+      ROS_WARN("Unknown drop policy '%s'. Using 'latest' instead.", dropPolicy.c_str());
+      pipelineState->dropPolicy = DropPolicy::Latest;
+    }
 
-        // update with the new data
-        for (auto person = 0; person < personCount; person++)
-        {
-          mFrame.persons[person].bodyParts.resize(bodyPartCount);
+    // openpose may step through the quality presets to hold the inference time within a budget
+    AdaptiveOptions adaptiveOptions;
+    nh.param("adaptive_quality", adaptiveOptions.enabled, adaptiveOptions.enabled);
+    nh.param("adaptive_target_fps", adaptiveOptions.targetFps, adaptiveOptions.targetFps);
+    nh.param("adaptive_target_latency", adaptiveOptions.targetLatency, adaptiveOptions.targetLatency);
+    nh.param("adaptive_down_threshold", adaptiveOptions.downThreshold, adaptiveOptions.downThreshold);
+    nh.param("adaptive_up_threshold", adaptiveOptions.upThreshold, adaptiveOptions.upThreshold);
+    nh.param("adaptive_window_size", adaptiveOptions.windowSize, adaptiveOptions.windowSize);
+    nh.param("adaptive_hold_time", adaptiveOptions.holdTime, adaptiveOptions.holdTime);
+    nh.param("adaptive_min_quality", adaptiveOptions.minQuality, adaptiveOptions.minQuality);
+    nh.param("adaptive_max_quality", adaptiveOptions.maxQuality, adaptiveOptions.maxQuality);
+
+    if (adaptiveOptions.enabled)
+    {
+      if (adaptiveOptions.targetFps <= 0.0 && adaptiveOptions.targetLatency <= 0.0)
+        ROS_WARN("Adaptive quality needs 'adaptive_target_fps' or 'adaptive_target_latency'. Disabling it.");
+      else
+      {
+        mSPtrQualityController = std::make_shared<QualityController>(adaptiveOptions);
+        pipelineState->qualityController = mSPtrQualityController;
+      }
+    }
 
-          for (auto bodyPart = 0; bodyPart < bodyPartCount; bodyPart++)
-          {
-            // src:
-            // https://github.com/CMU-Perceptual-Computing-Lab/openpose/blob/master/doc/output.md#keypoint-format-in-the-c-api
+    // synthetic frames may warm openpose up before the cameras are subscribed to. the size should match the
+    // one of the color images, as the network input and hence the algorithms picked by cudnn depend on it
+    int warmupFrames, warmupWidth, warmupHeight;
+    nh.param("warmup_frames", warmupFrames, 0);
+    nh.param("warmup_width", warmupWidth, 640);
+    nh.param("warmup_height", warmupHeight, 480);
+    pipelineState->warmupFrames = std::max(warmupFrames, 0);
+    pipelineState->warmupSize = cv::Size(std::max(warmupWidth, 1), std::max(warmupHeight, 1));
+    pipelineState->warmupCallback = [this](const unsigned int warmupArrived) { warmupCallback(warmupArrived); };
+
+    // orchestration may wait on this instead of guessing when the node is up
+    mReadyPublisher = nh.advertise<std_msgs::Bool>("ready", 1, true);
+    setReady(false);
+
+    // counters of the pipeline, e.g., the frames dropped at each stage
+    pipelineState->statsPublisher = nh.advertise<ros_openpose::PipelineStats>("pipeline_stats", 1);
+
+    // the percentiles of the stage durations for the dashboards, along with the achieved rate. the status is
+    // stale until the output worker filled it
+    nh.param("diagnostics", pipelineState->diagnostics, false);
+    pipelineState->diagnosticStatus.summary(diagnostic_msgs::DiagnosticStatus::STALE, "No frame processed yet");
+
+    // several cameras may feed the same wrapper, so that the network is loaded only once. each of
+    // them reads its topics from its own namespace, e.g., '~camera0/color_topic'. without the
+    // list, a single camera is read from the private namespace itself
+    std::vector<std::string> cameraNames;
+    nh.getParam("cameras", cameraNames);
+
+    // no image is received until openpose is warmed up, see warmupCallback()
+    cameraOptions.paused = pipelineState->warmupFrames > 0;
+
+    if (cameraNames.empty())
+      mCameras.push_back(createCamera(nh, cameraOptions));
+
+    for (const auto& cameraName : cameraNames)
+    {
+      ros::NodeHandle cameraNh(nh, cameraName);
+      mCameras.push_back(createCamera(cameraNh, cameraOptions));
+    }
 
-            // easy version
-            // auto x = poseKeypoints[{person, bodyPart, 0}];
-            // auto y = poseKeypoints[{person, bodyPart, 1}];
+    for (auto& camera : mCameras)
+    {
+      camera.personTracker = std::make_shared<PersonTracker>(outputOptions.tracker);
+      camera.keypointFilter = std::make_shared<KeypointFilter>(outputOptions.filter);
+    }
 
-            // slightly more efficient version
-            const auto baseIndex = poseKeypoints.getSize(2) * (person * bodyPartCount + bodyPart);
-            const auto x = poseKeypoints[baseIndex];
-            const auto y = poseKeypoints[baseIndex + 1];
-            const auto score = poseKeypoints[baseIndex + 2];
+    mOutputOptions = outputOptions;
+    mSPtrPipelineState = pipelineState;
+    configureOpenPose(mOpWrapper, mCameras, mOutputOptions, mSPtrPipelineState);
+
+    // the server starts with the values of the command-line flags rather than the defaults of the cfg file
+    const auto poseSettings = getPoseSettings();
+    RosOpenposeConfig config;
+    config.quality = -1;
+    config.net_resolution = poseSettings.netResolution;
+    config.scale_number = poseSettings.scaleNumber;
+    config.scale_gap = poseSettings.scaleGap;
+    config.number_people_max = poseSettings.numberPeopleMax;
+
+    mUPtrReconfigureServer.reset(new dynamic_reconfigure::Server<RosOpenposeConfig>(mReconfigureMutex, nh));
+    mUPtrReconfigureServer->updateConfig(config);
+    mUPtrReconfigureServer->setCallback(
+        [this](RosOpenposeConfig& config, const uint32_t level) { reconfigureCallback(config, level); });
+
+    if (mSPtrQualityController)
+      mAdaptiveTimer = nh.createWallTimer(ros::WallDuration(1.0), &RosOpenpose::adaptiveCallback, this);
+
+    // the period of the updater is read from '~diagnostic_period'
+    if (mSPtrPipelineState->diagnostics)
+    {
+      mUPtrDiagnosticUpdater.reset(new diagnostic_updater::Updater(ros::NodeHandle(), nh));
+      mUPtrDiagnosticUpdater->setHardwareID(PipelineProfiler::hardwareId());
+      mUPtrDiagnosticUpdater->add("pipeline", this, &RosOpenpose::diagnosticCallback);
+      mDiagnosticTimer = nh.createWallTimer(ros::WallDuration(mUPtrDiagnosticUpdater->getPeriod()),
+                                            &RosOpenpose::diagnosticTimerCallback, this);
+    }
 
-            float point3D[3];
-            mSPtrCameraReader->compute3DPoint(x, y, point3D);
+    // the callbacks above only record their requests until this thread applies them
+    mRestartThread = std::thread(&RosOpenpose::restartLoop, this);
 
-            mFrame.persons[person].bodyParts[bodyPart].pixel.x = x;
-            mFrame.persons[person].bodyParts[bodyPart].pixel.y = y;
-            mFrame.persons[person].bodyParts[bodyPart].score = score;
-            mFrame.persons[person].bodyParts[bodyPart].point.x = point3D[0];
-            mFrame.persons[person].bodyParts[bodyPart].point.y = point3D[1];
-            mFrame.persons[person].bodyParts[bodyPart].point.z = point3D[2];
-          }
-        }
+    ROS_INFO("Configured ros_openpose in %.2f s", (ros::WallTime::now() - mConstructionTime).toSec());
+  }
 
-        mFramePublisher.publish(mFrame);
-      }
+  RosOpenpose::~RosOpenpose()
+  {
+    // no more restarts from here on. a restart already running is finished first
+    mDiagnosticTimer.stop();
+    mAdaptiveTimer.stop();
+    mUPtrReconfigureServer.reset();
+    {
+      std::lock_guard<std::mutex> lock(mRestartMutex);
+      mRestartStopped = true;
     }
-    catch (const std::exception& e)
+    mRestartCondition.notify_one();
+    if (mRestartThread.joinable())
+      mRestartThread.join();
+    stop();
+  }
+
+  void RosOpenpose::start()
+  {
+    ROS_INFO("Starting ros_openpose...");
+    std::lock_guard<std::mutex> lock(mWrapperMutex);
+    startWrapper();
+  }
+
+  void RosOpenpose::startWrapper()
+  {
+    // the cameras were created paused in this case. they are resumed by the last warmup batch
+    const auto warmupFrames = mSPtrPipelineState->warmupFrames;
+
+    mStartTime = ros::WallTime::now();
+    mOpWrapper.start();
+    ROS_INFO("Started the openpose wrapper in %.2f s", (ros::WallTime::now() - mStartTime).toSec());
+
+    if (warmupFrames == 0)
+      setReady(true);
+    else
+      ROS_INFO("Warming openpose up with %u frames of %dx%d...", warmupFrames, mSPtrPipelineState->warmupSize.width,
+               mSPtrPipelineState->warmupSize.height);
+  }
+
+  void RosOpenpose::warmupCallback(const unsigned int warmupArrived)
+  {
+    // the first frame waits for caffe to load the weights and for cudnn to pick its algorithms
+    const auto now = ros::WallTime::now();
+    if (warmupArrived == 1)
     {
-      this->stop();
-      ROS_ERROR("Error %s at line number %d on function %s in file %s", e.what(), __LINE__, __FUNCTION__, __FILE__);
+      mFirstWarmupTime = now;
+      ROS_INFO("Loaded the network and processed the first warmup frame in %.2f s", (now - mStartTime).toSec());
     }
+
+    const auto warmupFrames = mSPtrPipelineState->warmupFrames;
+    if (warmupArrived != warmupFrames)
+      return;
+
+    if (warmupFrames > 1)
+      ROS_INFO("Processed the remaining warmup frames in %.1f ms each",
+               1e3 * (now - mFirstWarmupTime).toSec() / (warmupFrames - 1));
+
+    for (auto& camera : mCameras)
+      camera.subscriberMonitor->setPaused(false);
+    setReady(true);
   }
 
-private:
-  ros_openpose::Frame mFrame;
-  const ros::Publisher mFramePublisher;
-  const std::shared_ptr<ros_openpose::CameraReader> mSPtrCameraReader;
-};
-
-// clang-format off
-void configureOpenPose(op::Wrapper& opWrapper,
-                       const std::shared_ptr<ros_openpose::CameraReader>& cameraReader,
-                       const ros::Publisher& framePublisher,
-                       const std::string& frameId)
-// clang-format on
-{
-  try
+  void RosOpenpose::diagnosticTimerCallback(const ros::WallTimerEvent& event)
   {
-    // Configuring OpenPose
-
-    // clang-format off
-    // logging_level
-    op::check(0 <= FLAGS_logging_level && FLAGS_logging_level <= 255,
-              "Wrong logging_level value.",
-              __LINE__,
-              __FUNCTION__,
-              __FILE__);
-
-    op::ConfigureLog::setPriorityThreshold((op::Priority)FLAGS_logging_level);
-    op::Profiler::setDefaultX(FLAGS_profile_speed);
-
-    // Applying user defined configuration - GFlags to program variables
-    // outputSize
-    const auto outputSize = op::flagsToPoint(FLAGS_output_resolution, "-1x-1");
-
-    // netInputSize
-    const auto netInputSize = op::flagsToPoint(FLAGS_net_resolution, "-1x368");
-
-    // faceNetInputSize
-    const auto faceNetInputSize = op::flagsToPoint(FLAGS_face_net_resolution, "368x368 (multiples of 16)");
-
-    // handNetInputSize
-    const auto handNetInputSize = op::flagsToPoint(FLAGS_hand_net_resolution, "368x368 (multiples of 16)");
-
-    // poseMode
-    const auto poseMode = op::flagsToPoseMode(FLAGS_body);
-
-    // poseModel
-    const auto poseModel = op::flagsToPoseModel(FLAGS_model_pose);
-
-    // JSON saving
-    if (!FLAGS_write_keypoint.empty())
-      ROS_INFO("Flag `write_keypoint` is deprecated and will eventually be removed. Please, use `write_json` instead.");
-
-    // keypointScaleMode
-    const auto keypointScaleMode = op::flagsToScaleMode(FLAGS_keypoint_scale);
-
-    // heatmaps to add
-    const auto heatMapTypes = op::flagsToHeatMaps(FLAGS_heatmaps_add_parts,
-                                                  FLAGS_heatmaps_add_bkg,
-                                                  FLAGS_heatmaps_add_PAFs);
-
-    const auto heatMapScaleMode = op::flagsToHeatMapScaleMode(FLAGS_heatmaps_scale);
-
-    // >1 camera view?
-    // const auto multipleView = (FLAGS_3d || FLAGS_3d_views > 1 || FLAGS_flir_camera);
-    const auto multipleView = false;
-
-    // Face and hand detectors
-    const auto faceDetector = op::flagsToDetector(FLAGS_face_detector);
-    const auto handDetector = op::flagsToDetector(FLAGS_hand_detector);
-
-    // Enabling Google Logging
-    const bool enableGoogleLogging = true;
-
-    // Initializing the user custom classes
-    auto wUserInput = std::make_shared<WUserInput>(cameraReader);
-    auto wUserOutput = std::make_shared<WUserOutput>(framePublisher, cameraReader, frameId);
-
-    // Add custom processing
-    const auto workerInputOnNewThread = true;
-    opWrapper.setWorker(op::WorkerType::Input, wUserInput, workerInputOnNewThread);
-
-    const auto workerOutputOnNewThread = true;
-    opWrapper.setWorker(op::WorkerType::Output, wUserOutput, workerOutputOnNewThread);
-
-    // Pose configuration (use WrapperStructPose{} for default and recommended configuration)
-    const op::WrapperStructPose wrapperStructPose{poseMode,
-                                                  netInputSize,
-                                                  outputSize,
-                                                  keypointScaleMode,
-                                                  FLAGS_num_gpu,
-                                                  FLAGS_num_gpu_start,
-                                                  FLAGS_scale_number,
-                                                  (float)FLAGS_scale_gap,
-                                                  op::flagsToRenderMode(FLAGS_render_pose,
-                                                                        multipleView),
-                                                  poseModel,
-                                                  !FLAGS_disable_blending,
-                                                  (float)FLAGS_alpha_pose,
-                                                  (float)FLAGS_alpha_heatmap,
-                                                  FLAGS_part_to_show,
-                                                  FLAGS_model_folder,
-                                                  heatMapTypes,
-                                                  heatMapScaleMode,
-                                                  FLAGS_part_candidates,
-                                                  (float)FLAGS_render_threshold,
-                                                  FLAGS_number_people_max,
-                                                  FLAGS_maximize_positives,
-                                                  FLAGS_fps_max,
-                                                  FLAGS_prototxt_path,
-                                                  FLAGS_caffemodel_path,
-                                                  (float)FLAGS_upsampling_ratio,
-                                                  enableGoogleLogging};
-    opWrapper.configure(wrapperStructPose);
-
-    // Face configuration (use op::WrapperStructFace{} to disable it)
-    const op::WrapperStructFace wrapperStructFace{FLAGS_face,
-                                                  faceDetector,
-                                                  faceNetInputSize,
-                                                  op::flagsToRenderMode(FLAGS_face_render,
-                                                                        multipleView,
-                                                                        FLAGS_render_pose),
-                                                  (float)FLAGS_face_alpha_pose,
-                                                  (float)FLAGS_face_alpha_heatmap,
-                                                  (float)FLAGS_face_render_threshold};
-    opWrapper.configure(wrapperStructFace);
-
-    // Hand configuration (use op::WrapperStructHand{} to disable it)
-    const op::WrapperStructHand wrapperStructHand{FLAGS_hand,
-                                                  handDetector,
-                                                  handNetInputSize,
-                                                  FLAGS_hand_scale_number,
-                                                  (float)FLAGS_hand_scale_range,
-                                                  op::flagsToRenderMode(FLAGS_hand_render,
-                                                                        multipleView,
-                                                                        FLAGS_render_pose),
-                                                  (float)FLAGS_hand_alpha_pose,
-                                                  (float)FLAGS_hand_alpha_heatmap,
-                                                  (float)FLAGS_hand_render_threshold};
-    opWrapper.configure(wrapperStructHand);
-
-    // Extra functionality configuration (use op::WrapperStructExtra{} to disable it)
-    const op::WrapperStructExtra wrapperStructExtra{FLAGS_3d,
-                                                    FLAGS_3d_min_views,
-                                                    FLAGS_identification,
-                                                    FLAGS_tracking,
-                                                    FLAGS_ik_threads};
-    opWrapper.configure(wrapperStructExtra);
-
-    // Output (comment or use default argument to disable any output)
-    const op::WrapperStructOutput wrapperStructOutput{FLAGS_cli_verbose,
-                                                      FLAGS_write_keypoint,
-                                                      op::stringToDataFormat(FLAGS_write_keypoint_format),
-                                                      FLAGS_write_json,
-                                                      FLAGS_write_coco_json,
-                                                      FLAGS_write_coco_json_variants,
-                                                      FLAGS_write_coco_json_variant,
-                                                      FLAGS_write_images,
-                                                      FLAGS_write_images_format,
-                                                      FLAGS_write_video,
-                                                      FLAGS_write_video_fps,
-                                                      FLAGS_write_video_with_audio,
-                                                      FLAGS_write_heatmaps,
-                                                      FLAGS_write_heatmaps_format,
-                                                      FLAGS_write_video_3d,
-                                                      FLAGS_write_video_adam,
-                                                      FLAGS_write_bvh,
-                                                      FLAGS_udp_host,
-                                                      FLAGS_udp_port};
-    opWrapper.configure(wrapperStructOutput);
-
-    // GUI (comment or use default argument to disable any visual output)
-    const op::WrapperStructGui wrapperStructGui{op::flagsToDisplayMode(FLAGS_display,
-                                                                       FLAGS_3d),
-                                                !FLAGS_no_gui_verbose,
-                                                FLAGS_fullscreen};
-    opWrapper.configure(wrapperStructGui);
-    // clang-format on
-
-    // Set to single-thread (for sequential processing and/or debugging and/or reducing latency)
-    if (FLAGS_disable_multi_thread)
-      opWrapper.disableMultiThreading();
+    // the timer already runs at the period of the updater
+    mUPtrDiagnosticUpdater->force_update();
   }
-  catch (const std::exception& e)
+
+  void RosOpenpose::diagnosticCallback(diagnostic_updater::DiagnosticStatusWrapper& status)
   {
-    ROS_ERROR("Error %s at line number %d on function %s in file %s", e.what(), __LINE__, __FUNCTION__, __FILE__);
+    std::lock_guard<std::mutex> lock(mSPtrPipelineState->mutex);
+    status.summary(mSPtrPipelineState->diagnosticStatus);
+    status.values = mSPtrPipelineState->diagnosticStatus.values;
   }
-}
 
-int main(int argc, char* argv[])
-{
-  ros::init(argc, argv, "ros_openpose_node");
-  ros::NodeHandle nh("~");
+  void RosOpenpose::setReady(const bool ready)
+  {
+    std_msgs::Bool message;
+    message.data = ready;
+    mReadyPublisher.publish(message);
 
-  // define the parameters, we are going to read
-  std::string openposeModelDir, colorTopic, depthTopic, camInfoTopic, frameId, pubTopic;
+    if (ready)
+      ROS_INFO("ros_openpose is ready, %.2f s after it was constructed",
+               (ros::WallTime::now() - mConstructionTime).toSec());
+  }
 
-  // read the parameters from relative nodel handle
-  nh.getParam("openpose_model_dir", openposeModelDir);
-  nh.getParam("color_topic", colorTopic);
-  nh.getParam("depth_topic", depthTopic);
-  nh.getParam("cam_info_topic", camInfoTopic);
-  nh.getParam("frame_id", frameId);
-  nh.getParam("pub_topic", pubTopic);
+  void RosOpenpose::stop()
+  {
+    if (mOpWrapper.isRunning())
+    {
+      ROS_INFO("Exiting ros_openpose...");
+      mOpWrapper.stop();
+    }
+  }
 
-  if (openposeModelDir.empty())
+  PoseSettings RosOpenpose::getPoseSettings() const
   {
-    ROS_FATAL("Missing 'openpose_model_dir' info in launch file");
-    exit(-1);
+    std::lock_guard<std::mutex> lock(mWrapperMutex);
+    return PoseSettings(FLAGS_net_resolution, FLAGS_scale_number, FLAGS_scale_gap, FLAGS_number_people_max);
   }
 
-  // path of the dir where openpose models are located
-  FLAGS_model_folder = openposeModelDir;
+  void RosOpenpose::applyPoseSettings(const PoseSettings& settings)
+  {
+    std::lock_guard<std::mutex> lock(mWrapperMutex);
+    const PoseSettings current(FLAGS_net_resolution, FLAGS_scale_number, FLAGS_scale_gap, FLAGS_number_people_max);
+    if (settings == current)
+      return;
+
+    ROS_INFO("Restarting openpose with net_resolution %s, scale_number %d, scale_gap %.2f and number_people_max %d",
+             settings.netResolution.c_str(), settings.scaleNumber, settings.scaleGap, settings.numberPeopleMax);
+
+    const auto running = mOpWrapper.isRunning();
+    if (running)
+    {
+      setReady(false);
+      mOpWrapper.stop();
+    }
+
+    // the wrapper is configured from the flags, just like at the start
+    FLAGS_net_resolution = settings.netResolution;
+    FLAGS_scale_number = settings.scaleNumber;
+    FLAGS_scale_gap = settings.scaleGap;
+    FLAGS_number_people_max = settings.numberPeopleMax;
 
-  // parsing command line flags
-  gflags::ParseCommandLineFlags(&argc, &argv, true);
+    // openpose is warmed up by the first start only. the cameras which still wait for its warmup are resumed
+    mSPtrPipelineState->warmupFrames = 0;
+    for (auto& camera : mCameras)
+      camera.subscriberMonitor->setPaused(false);
 
-  const auto cameraReader = std::make_shared<ros_openpose::CameraReader>(nh, colorTopic, depthTopic, camInfoTopic);
+    // the batches inside openpose were dropped along with its queues
+    {
+      std::lock_guard<std::mutex> pipelineLock(mSPtrPipelineState->mutex);
+      mSPtrPipelineState->batchesConsumed = mSPtrPipelineState->batchesProduced;
+      mSPtrPipelineState->skippedBatches.clear();
+    }
 
-  // the frame consists of the location of detected body parts of each person
-  const ros::Publisher framePublisher = nh.advertise<ros_openpose::Frame>(pubTopic, 1);
+    // new workers, as the sequence numbers of the batches start over. the trackers and the filters are kept
+    configureOpenPose(mOpWrapper, mCameras, mOutputOptions, mSPtrPipelineState);
+    if (running)
+      startWrapper();
+  }
 
-  try
+  void RosOpenpose::requestPoseSettings(const PoseSettings& settings)
   {
-    ROS_INFO("Starting ros_openpose...");
-    op::Wrapper opWrapper;
-    configureOpenPose(opWrapper, cameraReader, framePublisher, frameId);
+    {
+      std::lock_guard<std::mutex> lock(mRestartMutex);
+      mRequestedSettings = settings;
+      mRestartRequested = true;
+    }
+    mRestartCondition.notify_one();
+  }
+
+  void RosOpenpose::restartLoop()
+  {
+    while (true)
+    {
+      PoseSettings settings;
+      {
+        std::unique_lock<std::mutex> lock(mRestartMutex);
+        mRestartCondition.wait(lock, [this] { return mRestartRequested || mRestartStopped; });
+        if (mRestartStopped)
+          return;
+
+        settings = mRequestedSettings;
+        mRestartRequested = false;
+        mRestartRunning = true;
+      }
 
-    // start and run
-    opWrapper.start();
+      // an exception would end the thread and hence the node, e.g., for a resolution openpose can not parse
+      try
+      {
+        applyPoseSettings(settings);
+      }
+      catch (const std::exception& e)
+      {
+        ROS_ERROR("Could not restart openpose: %s", e.what());
+      }
+
+      std::lock_guard<std::mutex> lock(mRestartMutex);
+      mRestartRunning = false;
+    }
+  }
 
-    // exit when Ctrl-C is pressed, or the node is shutdown by the master
-    ros::spin();
+  void RosOpenpose::reconfigureCallback(RosOpenposeConfig& config, const uint32_t level)
+  {
+    PoseSettings settings(config.net_resolution, config.scale_number, config.scale_gap, config.number_people_max);
 
-    // return successful message
-    ROS_INFO("Exiting ros_openpose...");
+    // a preset overrides the resolution and the scales. they are shown in the reconfigure gui as well
+    if (applyQualityPreset(config.quality, settings))
+    {
+      config.net_resolution = settings.netResolution;
+      config.scale_number = settings.scaleNumber;
+      config.scale_gap = settings.scaleGap;
+    }
 
-    // stop processing
-    opWrapper.stop();
-    return 0;
+    requestPoseSettings(settings);
   }
-  catch (const std::exception& e)
+
+  void RosOpenpose::adaptiveCallback(const ros::WallTimerEvent& event)
   {
-    ROS_ERROR("Error %s at line number %d on function %s in file %s", e.what(), __LINE__, __FUNCTION__, __FILE__);
-    return -1;
+    // the inference times belong to the old settings while a restart is pending or running
+    {
+      std::lock_guard<std::mutex> lock(mRestartMutex);
+      if (mRestartRequested || mRestartRunning)
+        return;
+    }
+
+    // only while openpose is running, i.e., not before start(). the wrapper mutex is not waited for, so that
+    // the spinner never blocks on a restart
+    std::unique_lock<std::mutex> wrapperLock(mWrapperMutex, std::try_to_lock);
+    if (!wrapperLock.owns_lock() || !mOpWrapper.isRunning())
+      return;
+
+    PoseSettings settings(FLAGS_net_resolution, FLAGS_scale_number, FLAGS_scale_gap, FLAGS_number_people_max);
+    wrapperLock.unlock();
+
+    int quality;
+    if (!mSPtrQualityController->update(settings, ros::WallTime::now().toSec(), quality))
+      return;
+
+    applyQualityPreset(quality, settings);
+    requestPoseSettings(settings);
+
+    // show the new values in the reconfigure gui as well. the server only publishes them, reconfigureCallback
+    // is not invoked. were it invoked, it would request the same settings, which applyPoseSettings ignores
+    RosOpenposeConfig config;
+    config.quality = quality;
+    config.net_resolution = settings.netResolution;
+    config.scale_number = settings.scaleNumber;
+    config.scale_gap = settings.scaleGap;
+    config.number_people_max = settings.numberPeopleMax;
+    mUPtrReconfigureServer->updateConfig(config);
   }
 }
@@ -0,0 +1,295 @@
+/**
+* rosOpenposeBag.cpp: processes the frames recorded in a bag offline. the color and depth images are
+*                     paired by their stamps and pushed through the same workers as the live node, as
+*                     fast as openpose allows. the frames are written into another bag
+* Date: 2026/10/14
+*/
+
+// ROS headers
+#include <ros/ros.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+
+// ros_openpose headers
+#include <ros_openpose/rosOpenpose.hpp>
+
+// c++ headers
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <thread>
+
+namespace ros_openpose
+{
+  // the largest number of images waiting for their counterpart. it bounds the memory if one of the topics
+  // is missing in a part of the bag
+  const size_t MAX_PENDING_IMAGES = 100;
+
+  // pairs the color and depth images read from a bag. unlike the synchronizer of the live node, it sees the
+  // images ahead, hence a color image is paired with the nearest depth image rather than the first one found
+  class FramePairer
+  {
+  public:
+    typedef std::function<void(const sensor_msgs::ImageConstPtr&, const sensor_msgs::ImageConstPtr&)> PairCallback;
+
+    // 'maxInterval' is the largest difference (in seconds) between the stamps of a pair. zero pairs the
+    // images with identical stamps only
+    FramePairer(const double maxInterval, const PairCallback& pairCallback)
+      : mMaxInterval(std::max(maxInterval, 0.0)), mPairCallback(pairCallback)
+    {
+    }
+
+    void addColor(const sensor_msgs::ImageConstPtr& colorMsg)
+    {
+      mColors.push_back(colorMsg);
+      match(false);
+    }
+
+    void addDepth(const sensor_msgs::ImageConstPtr& depthMsg)
+    {
+      mDepths.push_back(depthMsg);
+      if (mDepths.size() > MAX_PENDING_IMAGES)
+        mDepths.pop_front();
+      match(false);
+    }
+
+    // pairs the remaining color images at the end of the bag
+    void flush()
+    {
+      match(true);
+    }
+
+    // the color images for which no depth image was found
+    unsigned long long unmatched() const
+    {
+      return mUnmatched;
+    }
+
+  private:
+    // the stamps of each topic are expected to increase. a color image is paired once a depth image with a
+    // later stamp arrived, as there can not be a nearer one afterwards
+    void match(const bool final)
+    {
+      while (!mColors.empty())
+      {
+        const auto& colorMsg = mColors.front();
+        const auto stamp = colorMsg->header.stamp;
+
+        // the depth images which are too old for this color image are too old for the later ones as well
+        while (!mDepths.empty() && (stamp - mDepths.front()->header.stamp).toSec() > mMaxInterval)
+          mDepths.pop_front();
+
+        const auto later = std::find_if(mDepths.begin(), mDepths.end(),
+                                        [&](const sensor_msgs::ImageConstPtr& depthMsg) {
+                                          return depthMsg->header.stamp >= stamp;
+                                        });
+        if (later == mDepths.end() && !final && mColors.size() <= MAX_PENDING_IMAGES)
+          return;
+
+        // the nearest depth image is either the last one before the color image or the first one after it
+        auto nearest = mDepths.end();
+        double nearestInterval = mMaxInterval;
+        if (later != mDepths.begin())
+        {
+          nearest = later - 1;
+          nearestInterval = (stamp - (*nearest)->header.stamp).toSec();
+        }
+        if (later != mDepths.end())
+        {
+          const auto interval = ((*later)->header.stamp - stamp).toSec();
+          if (interval <= nearestInterval)
+          {
+            nearest = later;
+            nearestInterval = interval;
+          }
+        }
+
+        if (nearest != mDepths.end())
+        {
+          mPairCallback(colorMsg, *nearest);
+          mDepths.erase(mDepths.begin(), nearest + 1);
+        }
+        else
+          mUnmatched++;
+        mColors.pop_front();
+      }
+    }
+
+    const double mMaxInterval;
+    const PairCallback mPairCallback;
+    std::deque<sensor_msgs::ImageConstPtr> mColors, mDepths;
+    unsigned long long mUnmatched = 0;
+  };
+
+  // reads the first camera info of the bag into the camera reader. returns false if there is none
+  static bool readCameraInfo(const rosbag::Bag& bag, const std::string& camInfoTopic, Camera& camera)
+  {
+    rosbag::View view(bag, rosbag::TopicQuery(camInfoTopic));
+    for (const auto& message : view)
+    {
+      const auto camInfo = message.instantiate<sensor_msgs::CameraInfo>();
+      if (!camInfo)
+        continue;
+
+      camera.cameraReader->setCameraInfo(camInfo);
+      if (camera.frameId.empty())
+        camera.frameId = camInfo->header.frame_id;
+      return true;
+    }
+    return false;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  using namespace ros_openpose;
+
+  ros::init(argc, argv, "ros_openpose_bag");
+  ros::NodeHandle nh("~");
+
+  // read the model dir from the parameter server and parse the openpose command-line flags
+  if (!initOpenPoseFlags(nh, std::vector<std::string>(argv, argv + argc)))
+    exit(-1);
+
+  // the topics are looked up in the bag as they were recorded
+  std::string inputBagPath, outputBagPath, colorTopic, depthTopic, camInfoTopic, frameTopic;
+  Camera camera;
+  nh.getParam("input_bag", inputBagPath);
+  nh.getParam("output_bag", outputBagPath);
+  nh.param<std::string>("color_topic", colorTopic, "/camera/color/image_raw");
+  nh.param<std::string>("depth_topic", depthTopic, "/camera/aligned_depth_to_color/image_raw");
+  nh.param<std::string>("cam_info_topic", camInfoTopic, "/camera/color/camera_info");
+  nh.param<std::string>("frame_topic", frameTopic, "/frame");
+  nh.getParam("frame_id", camera.frameId);
+
+  double syncMaxInterval;
+  int pipelineDepth;
+  nh.param("sync_max_interval", syncMaxInterval, 0.0);
+  nh.param("pipeline_depth", pipelineDepth, 16);
+
+  if (inputBagPath.empty() || outputBagPath.empty())
+  {
+    ROS_FATAL("Missing 'input_bag' or 'output_bag' info");
+    exit(-1);
+  }
+
+  try
+  {
+    rosbag::Bag inputBag(inputBagPath, rosbag::bagmode::Read);
+    rosbag::Bag outputBag(outputBagPath, rosbag::bagmode::Write);
+
+    // the camera reader gets its frames from the bag, hence it subscribes to nothing. every frame is
+    // processed in full, i.e., neither the region of interest nor the motion detector are used
+    auto depthSampling = DepthSampling::Nearest;
+    auto depthWindowSize = 5;
+    readDepthSampling(nh, depthSampling, depthWindowSize);
+    camera.cameraReader = std::make_shared<CameraReader>(nh, "", "", "");
+    camera.cameraReader->setDepthSampling(depthSampling, depthWindowSize);
+    camera.regionOfInterest = std::make_shared<RegionOfInterest>(RoiOptions());
+    camera.motionDetector = std::make_shared<MotionDetector>(MotionOptions());
+    camera.inputPreprocessor = std::make_shared<InputPreprocessor>(PreprocessOptions());
+    camera.skeletonPublisher =
+        std::make_shared<SkeletonPublisher>(nh, "", "", SkeletonOptions(), ros::SubscriberStatusCallback());
+    camera.subscriberMonitor = std::make_shared<SubscriberMonitor>(camera.cameraReader, false);
+
+    // the intrinsics are needed before the first frame
+    if (!readCameraInfo(inputBag, camInfoTopic, camera))
+    {
+      ROS_FATAL("No camera info found on '%s' in '%s'", camInfoTopic.c_str(), inputBagPath.c_str());
+      return -1;
+    }
+
+    // the frames are written by the output worker, with the stamp of their color image
+    std::atomic<unsigned long long> framesWritten{0};
+    camera.publishers.frameSink = [&](const ros_openpose::Frame& frame) {
+      outputBag.write(frameTopic, std::max(frame.header.stamp, ros::TIME_MIN), frame);
+      framesWritten++;
+    };
+
+    // every frame is published, in order. the input worker blocks while the queues of openpose are full, so
+    // that no frame is dropped, and the queues are deep enough to keep all of the gpus busy
+    auto outputOptions = readOutputOptions(nh);
+    outputOptions.order = OutputOrder::Strict;
+    camera.personTracker = std::make_shared<PersonTracker>(outputOptions.tracker);
+    camera.keypointFilter = std::make_shared<KeypointFilter>(outputOptions.filter);
+
+    auto pipelineState = std::make_shared<PipelineState>();
+    pipelineState->dropPolicy = DropPolicy::Queue;
+    pipelineState->depth = std::max(pipelineDepth, 1);
+
+    Wrapper opWrapper;
+    configureOpenPose(opWrapper, std::vector<Camera>{camera}, outputOptions, pipelineState);
+
+    ROS_INFO("Processing '%s' into '%s'...", inputBagPath.c_str(), outputBagPath.c_str());
+    opWrapper.start();
+    const auto startTime = ros::WallTime::now();
+
+    // a frame is handed over once openpose took the previous one, instead of replacing it
+    unsigned long long framesRead = 0;
+    FramePairer pairer(syncMaxInterval, [&](const sensor_msgs::ImageConstPtr& colorMsg,
+                                            const sensor_msgs::ImageConstPtr& depthMsg) {
+      while (!camera.cameraReader->waitForFrameTaken(std::chrono::milliseconds{100}))
+      {
+        if (!ros::ok() || !opWrapper.isRunning())
+          return;
+      }
+      camera.cameraReader->addFrame(colorMsg, depthMsg);
+      framesRead++;
+      ROS_INFO_THROTTLE(10, "Read %llu frames, wrote %llu frames (%.1f fps)", framesRead,
+                        static_cast<unsigned long long>(framesWritten),
+                        framesWritten / (ros::WallTime::now() - startTime).toSec());
+    });
+
+    rosbag::View view(inputBag, rosbag::TopicQuery(std::vector<std::string>{colorTopic, depthTopic}));
+    for (const auto& message : view)
+    {
+      // exit when Ctrl-C is pressed or openpose failed
+      if (!ros::ok() || !opWrapper.isRunning())
+        break;
+
+      const auto image = message.instantiate<sensor_msgs::Image>();
+      if (!image)
+        continue;
+
+      if (message.getTopic() == colorTopic)
+        pairer.addColor(image);
+      else
+        pairer.addDepth(image);
+    }
+    pairer.flush();
+
+    // wait for the frames still inside openpose. a frame openpose failed on never leaves it, hence
+    // we give up once no frame was written for a while
+    auto lastWritten = framesWritten.load();
+    auto lastProgressTime = ros::WallTime::now();
+    while (ros::ok() && opWrapper.isRunning() && framesWritten < framesRead)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds{100});
+      const auto now = ros::WallTime::now();
+      if (framesWritten != lastWritten)
+      {
+        lastWritten = framesWritten;
+        lastProgressTime = now;
+      }
+      else if ((now - lastProgressTime).toSec() > 10.0)
+      {
+        ROS_WARN("%llu frames did not leave openpose", framesRead - lastWritten);
+        break;
+      }
+    }
+
+    opWrapper.stop();
+    outputBag.close();
+
+    const auto duration = (ros::WallTime::now() - startTime).toSec();
+    ROS_INFO("Wrote %llu frames in %.1f seconds (%.1f fps). %llu color images had no depth image.",
+             static_cast<unsigned long long>(framesWritten), duration, framesWritten / duration, pairer.unmatched());
+    return 0;
+  }
+  catch (const std::exception& e)
+  {
+    ROS_ERROR("Error %s at line number %d on function %s in file %s", e.what(), __LINE__, __FUNCTION__, __FILE__);
+    return -1;
+  }
+}
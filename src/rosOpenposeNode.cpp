@@ -0,0 +1,41 @@
+/**
+* rosOpenposeNode.cpp: the main file. it runs ros_openpose as a standalone node.
+* Author: Ravi Joshi
+* Date: 2019/09/27
+*/
+
+// ROS headers
+#include <ros/ros.h>
+
+// ros_openpose headers
+#include <ros_openpose/rosOpenpose.hpp>
+
+int main(int argc, char* argv[])
+{
+  ros::init(argc, argv, "ros_openpose_node");
+  ros::NodeHandle nh("~");
+
+  // read the model dir from the parameter server and parse the openpose command-line flags
+  if (!ros_openpose::initOpenPoseFlags(nh, std::vector<std::string>(argv, argv + argc)))
+    exit(-1);
+
+  try
+  {
+    ros_openpose::RosOpenpose rosOpenpose(nh);
+
+    // start and run
+    rosOpenpose.start();
+
+    // exit when Ctrl-C is pressed, or the node is shutdown by the master
+    ros::spin();
+
+    // stop processing
+    rosOpenpose.stop();
+    return 0;
+  }
+  catch (const std::exception& e)
+  {
+    ROS_ERROR("Error %s at line number %d on function %s in file %s", e.what(), __LINE__, __FUNCTION__, __FILE__);
+    return -1;
+  }
+}
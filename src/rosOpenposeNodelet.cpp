@@ -0,0 +1,56 @@
+/**
+* rosOpenposeNodelet.cpp: the nodelet version of ros_openpose. when loaded into the same nodelet
+*                         manager as the camera driver, the images are received as shared
+*                         pointers without any serialization.
+* Date: 2026/10/14
+*/
+
+// ROS headers
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+// ros_openpose headers
+#include <ros_openpose/rosOpenpose.hpp>
+
+namespace ros_openpose
+{
+  class RosOpenposeNodelet : public nodelet::Nodelet
+  {
+  private:
+    std::unique_ptr<RosOpenpose> mUPtrRosOpenpose;
+
+    void onInit()
+    {
+      auto& nh = getPrivateNodeHandle();
+
+      // the standard openpose command-line arguments are passed as nodelet arguments.
+      // gflags skips the first argument, which is the program name
+      std::vector<std::string> args{getName()};
+      const auto& myArgv = getMyArgv();
+      args.insert(args.end(), myArgv.begin(), myArgv.end());
+
+      if (!initOpenPoseFlags(nh, args))
+        return;
+
+      try
+      {
+        mUPtrRosOpenpose.reset(new RosOpenpose(nh));
+        mUPtrRosOpenpose->start();
+      }
+      catch (const std::exception& e)
+      {
+        NODELET_ERROR("Error %s at line number %d on function %s in file %s", e.what(), __LINE__, __FUNCTION__,
+                      __FILE__);
+      }
+    }
+
+  public:
+    // make sure to stop the workers before the camera reader goes away
+    ~RosOpenposeNodelet()
+    {
+      mUPtrRosOpenpose.reset();
+    }
+  };
+}
+
+PLUGINLIB_EXPORT_CLASS(ros_openpose::RosOpenposeNodelet, nodelet::Nodelet)
@@ -0,0 +1,220 @@
+/**
+* skeletonPublisher.cpp: class file for SkeletonPublisher. each person is drawn as a line list of
+*                        its limbs along with its id written above the nose
+* Date: 2026/10/14
+*/
+
+// ros_openpose headers
+#include <ros_openpose/skeletonPublisher.hpp>
+
+// c++ headers
+#include <cstring>
+#include <utility>
+
+namespace ros_openpose
+{
+  // the limbs of the body models, i.e., the pairs of body parts connected by a line.
+  // src: https://github.com/CMU-Perceptual-Computing-Lab/openpose/blob/master/doc/output.md#keypoint-ordering
+  // clang-format off
+  static const std::vector<std::pair<int, int>> BODY_25_LIMBS{
+    {1, 8}, {1, 2}, {1, 5}, {2, 3}, {3, 4}, {5, 6}, {6, 7}, {8, 9}, {9, 10}, {10, 11}, {8, 12}, {12, 13},
+    {13, 14}, {1, 0}, {0, 15}, {15, 17}, {0, 16}, {16, 18}, {14, 19}, {19, 20}, {14, 21}, {11, 22}, {22, 23},
+    {11, 24}};
+  static const std::vector<std::pair<int, int>> COCO_LIMBS{
+    {1, 2}, {1, 5}, {2, 3}, {3, 4}, {5, 6}, {6, 7}, {1, 8}, {8, 9}, {9, 10}, {1, 11}, {11, 12}, {12, 13},
+    {1, 0}, {0, 14}, {14, 16}, {0, 15}, {15, 17}};
+  // clang-format on
+
+  // the colors of the persons, the same as those of visualizer.py
+  static const std::array<std::array<float, 3>, 8> COLORS{{{{0.98f, 0.30f, 0.30f}},
+                                                           {{0.12f, 0.63f, 0.42f}},
+                                                           {{0.26f, 0.09f, 0.91f}},
+                                                           {{0.77f, 0.44f, 0.14f}},
+                                                           {{0.92f, 0.73f, 0.14f}},
+                                                           {{0.00f, 0.61f, 0.88f}},
+                                                           {{1.00f, 0.65f, 0.60f}},
+                                                           {{0.59f, 0.00f, 0.56f}}}};
+
+  // the nose, i.e., the body part the id is written above
+  const int NOSE = 0;
+
+  // the layout of a point of the cloud: x, y, z and score as float32 followed by the person id as int32
+  const uint32_t CLOUD_POINT_STEP = 20;
+
+  SkeletonPublisher::SkeletonPublisher(ros::NodeHandle& nh, const std::string& markersTopic,
+                                       const std::string& cloudTopic, const SkeletonOptions& options,
+                                       const ros::SubscriberStatusCallback& statusCallback)
+    : mOptions(options)
+  {
+    if (!markersTopic.empty())
+      mMarkersPublisher =
+          nh.advertise<visualization_msgs::MarkerArray>(markersTopic, 1, statusCallback, statusCallback);
+
+    if (!cloudTopic.empty())
+      mCloudPublisher = nh.advertise<sensor_msgs::PointCloud2>(cloudTopic, 1, statusCallback, statusCallback);
+
+    const std::array<std::string, 5> fieldNames{{"x", "y", "z", "intensity", "id"}};
+    mCloud.fields.resize(fieldNames.size());
+    for (size_t i = 0; i < fieldNames.size(); i++)
+    {
+      auto& field = mCloud.fields[i];
+      field.name = fieldNames[i];
+      field.offset = 4 * i;
+      field.datatype = i + 1 < fieldNames.size() ? sensor_msgs::PointField::FLOAT32 : sensor_msgs::PointField::INT32;
+      field.count = 1;
+    }
+    mCloud.height = 1;
+    mCloud.point_step = CLOUD_POINT_STEP;
+    mCloud.is_bigendian = false;
+    mCloud.is_dense = true;
+  }
+
+  void SkeletonPublisher::publish(const std_msgs::Header& header, const Keypoints3D& keypoints,
+                                  const std::array<size_t, 4>& offsets, const std::array<int, 4>& partCounts,
+                                  const std::vector<int>& ids)
+  {
+    // the messages are only built if someone listens to them
+    mMarkersFilled = mMarkersPublisher.getNumSubscribers() > 0;
+    if (mMarkersFilled)
+    {
+      fillMarkers(header, keypoints, offsets[0], partCounts[0], ids);
+      mMarkersPublisher.publish(mMarkers);
+    }
+
+    mCloudFilled = mCloudPublisher.getNumSubscribers() > 0;
+    if (mCloudFilled)
+    {
+      fillCloud(header, keypoints, offsets, partCounts, ids);
+      mCloudPublisher.publish(mCloud);
+    }
+  }
+
+  void SkeletonPublisher::republish(const ros::Time& stamp)
+  {
+    if (mMarkersFilled && mMarkersPublisher.getNumSubscribers() > 0)
+    {
+      for (auto& marker : mMarkers.markers)
+        marker.header.stamp = stamp;
+      mMarkersPublisher.publish(mMarkers);
+    }
+
+    if (mCloudFilled && mCloudPublisher.getNumSubscribers() > 0)
+    {
+      mCloud.header.stamp = stamp;
+      mCloudPublisher.publish(mCloud);
+    }
+  }
+
+  void SkeletonPublisher::fillMarkers(const std_msgs::Header& header, const Keypoints3D& keypoints,
+                                      const size_t offset, const int partCount, const std::vector<int>& ids)
+  {
+    // the body model is told by the number of body parts. other models are drawn without limbs
+    static const std::vector<std::pair<int, int>> NO_LIMBS;
+    const auto& limbs = partCount == 25 ? BODY_25_LIMBS : partCount == 18 ? COCO_LIMBS : NO_LIMBS;
+
+    // the first marker removes the persons of the previous frame, then each person gets its
+    // skeleton and its id
+    const auto personCount = ids.size();
+    mMarkers.markers.resize(1 + 2 * personCount);
+    mMarkers.markers[0].header = header;
+    mMarkers.markers[0].action = visualization_msgs::Marker::DELETEALL;
+
+    size_t markerCount = 1;
+    for (size_t person = 0; person < personCount; person++)
+    {
+      // a tracked person keeps its color and id. otherwise, use the index of the person
+      const auto number = ids[person] >= 0 ? ids[person] : static_cast<int>(person) + 1;
+      const auto& color = COLORS[number % COLORS.size()];
+      const auto first = offset + person * partCount;
+
+      auto& skeleton = mMarkers.markers[markerCount++];
+      skeleton.header = header;
+      skeleton.ns = "skeleton";
+      skeleton.id = 2 * person;
+      skeleton.type = visualization_msgs::Marker::LINE_LIST;
+      skeleton.action = visualization_msgs::Marker::ADD;
+      skeleton.pose.orientation.w = 1.0;
+      skeleton.scale.x = mOptions.lineWidth;
+      skeleton.color.r = color[0];
+      skeleton.color.g = color[1];
+      skeleton.color.b = color[2];
+      skeleton.color.a = 1.f;
+      skeleton.lifetime = ros::Duration(1.0);
+
+      // only the limbs whose both ends are valid are drawn
+      skeleton.points.clear();
+      for (const auto& limb : limbs)
+      {
+        const auto a = first + limb.first;
+        const auto b = first + limb.second;
+        if (!keypoints.valid[a] || !keypoints.valid[b])
+          continue;
+
+        for (const auto i : {a, b})
+        {
+          geometry_msgs::Point point;
+          point.x = keypoints.x[i];
+          point.y = keypoints.y[i];
+          point.z = keypoints.z[i];
+          skeleton.points.push_back(point);
+        }
+      }
+
+      // the id is written above the nose
+      const auto nose = first + NOSE;
+      if (partCount <= NOSE || !keypoints.valid[nose])
+        continue;
+
+      auto& text = mMarkers.markers[markerCount++];
+      text.header = header;
+      text.ns = "skeleton";
+      text.id = 2 * person + 1;
+      text.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
+      text.action = visualization_msgs::Marker::ADD;
+      text.pose.position.x = keypoints.x[nose];
+      text.pose.position.y = keypoints.y[nose] - 0.05;
+      text.pose.position.z = keypoints.z[nose];
+      text.pose.orientation.w = 1.0;
+      text.scale.z = mOptions.textSize;
+      text.color = skeleton.color;
+      text.lifetime = skeleton.lifetime;
+      text.text = std::to_string(number);
+    }
+    mMarkers.markers.resize(markerCount);
+  }
+
+  void SkeletonPublisher::fillCloud(const std_msgs::Header& header, const Keypoints3D& keypoints,
+                                    const std::array<size_t, 4>& offsets, const std::array<int, 4>& partCounts,
+                                    const std::vector<int>& ids)
+  {
+    mCloud.header = header;
+
+    // only the valid keypoints are put into the cloud. the buffer is shrunk to them afterwards,
+    // which keeps its memory for the next frames
+    mCloud.data.resize(keypoints.size() * CLOUD_POINT_STEP);
+    size_t pointCount = 0;
+    auto data = mCloud.data.data();
+    for (size_t person = 0; person < ids.size(); person++)
+    {
+      for (size_t k = 0; k < partCounts.size(); k++)
+      {
+        const auto first = offsets[k] + person * partCounts[k];
+        for (auto i = first; i < first + partCounts[k]; i++)
+        {
+          if (!keypoints.valid[i])
+            continue;
+
+          const float values[4] = {keypoints.x[i], keypoints.y[i], keypoints.z[i], keypoints.score[i]};
+          std::memcpy(data, values, sizeof(values));
+          std::memcpy(data + sizeof(values), &ids[person], sizeof(int32_t));
+          data += CLOUD_POINT_STEP;
+          pointCount++;
+        }
+      }
+    }
+
+    mCloud.data.resize(pointCount * CLOUD_POINT_STEP);
+    mCloud.width = pointCount;
+    mCloud.row_step = mCloud.width * CLOUD_POINT_STEP;
+  }
+}
@@ -0,0 +1,60 @@
+/**
+* subscriberMonitor.cpp: class file for SubscriberMonitor
+* Date: 2026/10/14
+*/
+
+// ros_openpose headers
+#include <ros_openpose/subscriberMonitor.hpp>
+
+namespace ros_openpose
+{
+  SubscriberMonitor::SubscriberMonitor(const std::shared_ptr<CameraReader>& sPtrCameraReader, const bool enabled)
+    : mSPtrCameraReader(sPtrCameraReader), mEnabled(enabled)
+  {
+  }
+
+  ros::SubscriberStatusCallback SubscriberMonitor::statusCallback()
+  {
+    if (!mEnabled)
+      return ros::SubscriberStatusCallback();
+
+    // the publishers may outlive the monitor
+    const std::weak_ptr<SubscriberMonitor> weakMonitor = shared_from_this();
+    return [weakMonitor](const ros::SingleSubscriberPublisher&) {
+      if (const auto monitor = weakMonitor.lock())
+        monitor->update();
+    };
+  }
+
+  void SubscriberMonitor::addPublisher(const ros::Publisher& publisher)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (publisher)
+      mPublishers.push_back(publisher);
+  }
+
+  void SubscriberMonitor::update()
+  {
+    // the callbacks of several publishers may run at the same time
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mPaused || !mEnabled)
+    {
+      mSPtrCameraReader->setActive(!mPaused);
+      return;
+    }
+
+    uint32_t subscribers = 0;
+    for (const auto& publisher : mPublishers)
+      subscribers += publisher.getNumSubscribers();
+    mSPtrCameraReader->setActive(subscribers > 0);
+  }
+
+  void SubscriberMonitor::setPaused(const bool paused)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mPaused = paused;
+    }
+    update();
+  }
+}
@@ -15,10 +15,15 @@ typedef std::shared_ptr<ros_openpose::CameraReader> sPtrCameraReader;
 void show(sPtrCameraReader readers)
 {
   ros::Rate loopRate(10);
+  unsigned long long frameNumber = 0;
+  cv_bridge::CvImageConstPtr colorImagePtr, depthImagePtr;
+  ros::Time callbackTime;
   while (ros::ok())
   {
-    auto colorImage = readers->getColorFrame();
-    auto depthImage = readers->getDepthFrame();
+    // the color and depth images of a frame are synchronized. the previous frame is kept if there is no new one
+    readers->waitForNewFrame(colorImagePtr, depthImagePtr, frameNumber, callbackTime, std::chrono::milliseconds{0});
+    const auto colorImage = colorImagePtr ? colorImagePtr->image : cv::Mat();
+    const auto depthImage = depthImagePtr ? depthImagePtr->image : cv::Mat();
 
     if (!colorImage.empty())
     {